@@ -6,6 +6,11 @@ import PageManager from './components/PageManager';
 import ColorSwitcher from './components/ColorSwitcher';
 import ExportButton from './components/ExportButton';
 
+// Context sent as prev=: the last few words before the caret word (the
+// backend ranks with the last two words of the current sentence)
+const CONTEXT_WORDS = 3;
+const CONTEXT_PATTERN = new RegExp(`(?:\\S+\\s+){0,${CONTEXT_WORDS}}\\S*$`, 'u');
+
 function App() {
   // ==========================================
   // MULTI-PAGE STATE MANAGEMENT
@@ -28,6 +33,9 @@ function App() {
   const editorRef = useRef(null);
   const suggestionTimerRef = useRef(null);
   const isReplacingWord = useRef(false);
+  // True while the bubble shows next-word predictions (inserted at the
+  // caret) rather than corrections for the word being typed
+  const isPredicting = useRef(false);
 
   // ==========================================
   // PAGE MANAGEMENT FUNCTIONS
@@ -191,7 +199,7 @@ function App() {
 
   const getWordAtCaret = useCallback((element) => {
     const selection = window.getSelection();
-    if (!selection.rangeCount) return { word: '', offset: 0, wordStart: 0, wordEnd: 0 };
+    if (!selection.rangeCount) return { word: '', offset: 0, wordStart: 0, wordEnd: 0, context: '' };
 
     const range = selection.getRangeAt(0);
     const preCaretRange = range.cloneRange();
@@ -207,19 +215,22 @@ function App() {
     let wordStart = caretOffset;
     let wordEnd = caretOffset;
     
-    // Move backwards to find word start (include letters, digits, and hyphens within words)
-    while (wordStart > 0 && /[a-zA-Z0-9]/.test(fullText[wordStart - 1])) {
+    // Move backwards to find word start (include letters, digits, apostrophes, and hyphens within words)
+    while (wordStart > 0 && /[\p{L}\p{N}'-]/u.test(fullText[wordStart - 1])) {
       wordStart--;
     }
     
-    // Move forwards to find word end (include letters, digits, and hyphens within words)
-    while (wordEnd < fullText.length && /[a-zA-Z0-9]/.test(fullText[wordEnd])) {
+    // Move forwards to find word end (include letters, digits, apostrophes, and hyphens within words)
+    while (wordEnd < fullText.length && /[\p{L}\p{N}'-]/u.test(fullText[wordEnd])) {
       wordEnd++;
     }
     
     const word = fullText.substring(wordStart, caretOffset);
     
-    return { word, offset: caretOffset, wordStart, wordEnd };
+    // Text before the word, for context-aware ranking
+    const context = fullText.substring(Math.max(0, wordStart - 200), wordStart).match(CONTEXT_PATTERN)[0];
+    
+    return { word, offset: caretOffset, wordStart, wordEnd, context };
   }, []);
 
   // ==========================================
@@ -351,18 +362,26 @@ function App() {
   // INPUT HANDLING AND SUGGESTION FETCHING
   // ==========================================
 
-  const fetchSuggestions = useCallback(async (word) => {
+  const fetchSuggestions = useCallback(async (word, context) => {
     try {
-      const response = await fetch(`/suggest?word=${encodeURIComponent(word)}`);
+      // Without a word, ask for the likely next words after the context
+      const predicting = word.length === 0;
+      const prev = context.trim() ? `prev=${encodeURIComponent(context)}` : '';
+      const url = predicting
+        ? `/predict?${prev}`
+        : `/suggest?word=${encodeURIComponent(word)}${prev ? `&${prev}` : ''}`;
+      const response = await fetch(url);
 
       if (!response.ok) {
         throw new Error(`HTTP ${response.status}`);
       }
 
       const data = await response.json();
+      const results = predicting ? data.predictions : data.suggestions;
 
-      if (data.suggestions && Array.isArray(data.suggestions) && data.suggestions.length > 0) {
-        setSuggestions(data.suggestions.slice(0, 5));
+      if (results && Array.isArray(results) && results.length > 0) {
+        isPredicting.current = predicting;
+        setSuggestions(results.slice(0, 5));
         setSelectedSuggestionIndex(-1);
 
         const coords = getCaretCoordinates();
@@ -389,7 +408,7 @@ function App() {
     updatePageContent(editor.innerHTML);
     
     // Get word at caret
-    const { word } = getWordAtCaret(editor);
+    const { word, context } = getWordAtCaret(editor);
     setCurrentWord(word);
 
     // Clear any pending suggestion timers
@@ -397,10 +416,12 @@ function App() {
       clearTimeout(suggestionTimerRef.current);
     }
 
-    // Fetch suggestions if word is long enough
-    if (word && word.length >= 2) {
+    // Fetch suggestions if word is long enough, or predictions right after
+    // a space that follows a word
+    const afterSpace = !word && /[\p{L}\p{N}'-]\s$/u.test(context);
+    if ((word && word.length >= 2) || afterSpace) {
       suggestionTimerRef.current = setTimeout(() => {
-        fetchSuggestions(word);
+        fetchSuggestions(word || '', context);
       }, 200);
     } else {
       setShowSuggestions(false);
@@ -419,8 +440,14 @@ function App() {
     // Ensure editor has focus
     editor.focus();
 
-    // Replace word using improved logic
-    const replaced = replaceWordAtCaret(editor, suggestion);
+    // Predictions are new words at the caret; corrections replace the word
+    let replaced;
+    if (isPredicting.current) {
+      replaced = document.execCommand('insertText', false, suggestion);
+      updatePageContent(editor.innerHTML);
+    } else {
+      replaced = replaceWordAtCaret(editor, suggestion);
+    }
     
     if (replaced) {
       // Hide suggestions immediately
@@ -433,7 +460,7 @@ function App() {
         clearTimeout(suggestionTimerRef.current);
       }
     }
-  }, [replaceWordAtCaret]);
+  }, [replaceWordAtCaret, updatePageContent]);
 
   // ==========================================
   // EVENT HANDLERS
@@ -603,6 +630,9 @@ function App() {
           setSelectedSuggestionIndex(prev =>
             prev > 0 ? prev - 1 : suggestions.length - 1
           );
+        } else if (e.key === 'Enter' && isPredicting.current && selectedSuggestionIndex < 0) {
+          // Nothing picked yet: Enter is a new line, not a prediction
+          setShowSuggestions(false);
         } else if (e.key === 'Enter' || e.key === 'Tab') {
           e.preventDefault();
           const indexToUse = selectedSuggestionIndex >= 0 ? selectedSuggestionIndex : 0;
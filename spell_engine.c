@@ -3,12 +3,21 @@
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <time.h>
 #ifdef _WIN32
     #include <winsock2.h>
     #include <ws2tcpip.h>
+    #include <psapi.h>
     #pragma comment(lib, "ws2_32.lib")
+    #pragma comment(lib, "psapi.lib")
 #else
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <sys/stat.h>
     #include <sys/socket.h>
+    #include <sys/select.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
     #include <unistd.h>
@@ -22,17 +31,67 @@
 // MODULE 1: DATA STRUCTURES
 // ==========================================
 
-#define ALPHABET_SIZE 26
+#define MAX_SYMBOLS 128
+#define CHILD_BITMAP_WORDS (MAX_SYMBOLS / 64)
+#define SYMBOL_UNKNOWN 255
 #define MAX_WORD_LENGTH 100
 #define TOP_K 5
+#define RERANK_POOL (3 * TOP_K)
+#define POOL_BLOCK_SIZE (1 << 20)
+
+#define SERVER_PORT 8080
+#define SHARD_BASE_PORT 9100
+// A shard scans its whole slice per query: 100-300 ms per query on the
+// 89k dictionary when all shards share one core, so leave ~3x headroom
+#define SHARD_DEADLINE_MS 1000
+#define MAX_SHARDS 32
 
 // Trie Node Structure
+// Children are packed in symbol order: bit s of child_bits says symbol s has
+// a child, and its slot is the number of set bits below s. Arrays are sized
+// to the next power of two of child_count so they can grow in place.
 typedef struct TrieNode {
-    struct TrieNode* children[ALPHABET_SIZE];
-    int isEndOfWord;
+    unsigned long long child_bits[CHILD_BITMAP_WORDS];
+    struct TrieNode** children;
     char* word;
+    unsigned char child_count;
+    unsigned char isEndOfWord;
 } TrieNode;
 
+// Dense alphabet: every case-folded codepoint the dictionary uses gets a
+// small symbol id, assigned in codepoint order so sorted word lists stay
+// sorted in symbol order
+typedef struct {
+    int size;
+    unsigned int codepoint[MAX_SYMBOLS];       // symbol id -> folded codepoint
+    unsigned char ascii_slot[128];             // folded ASCII -> symbol id + 1 (0 = absent)
+    unsigned int wide_codepoint[MAX_SYMBOLS];  // sorted non-ASCII codepoints
+    unsigned char wide_id[MAX_SYMBOLS];
+    int wide_count;
+    double distance[MAX_SYMBOLS][MAX_SYMBOLS]; // keyboard-aware substitution cost
+} Alphabet;
+
+// Case folding: codepoints in [lo, hi] (every `stride`-th one from lo) map to cp + delta
+typedef struct {
+    unsigned int lo;
+    unsigned int hi;
+    int delta;
+    int stride;
+} CaseFoldRange;
+
+// Slab pool: nodes and child arrays are carved out of large zeroed blocks
+// instead of one malloc each, and the trie is never freed node by node
+typedef struct PoolBlock {
+    struct PoolBlock* next;
+    size_t used;
+    size_t size;
+} PoolBlock;
+
+typedef struct {
+    PoolBlock* head;
+    size_t bytes;
+} NodePool;
+
 // Enhanced result structure
 typedef struct {
     char* word;
@@ -40,14 +99,15 @@ typedef struct {
     int match_type; // 0=exact, 1=prefix, 2=fuzzy
 } EnhancedResult;
 
-// Enhanced heap for Top-5
+// Enhanced heap for Top-K (up to RERANK_POOL when the caller reranks)
 typedef struct {
-    EnhancedResult elements[TOP_K];
+    EnhancedResult elements[RERANK_POOL];
     int count;
+    int capacity;
 } EnhancedHeap;
 
 // ==========================================
-// MODULE 2: KEYBOARD DISTANCE LOGIC
+// MODULE 2: ALPHABET & KEYBOARD DISTANCE
 // ==========================================
 
 const char* keyboard_rows[3] = {
@@ -91,15 +151,214 @@ double keyboard_distance(char a, char b) {
     return distance;
 }
 
+// Upper -> lower case for ASCII, Latin-1, Latin Extended-A, Greek and Cyrillic
+const CaseFoldRange case_fold_ranges[] = {
+    { 0x0041, 0x005A,  32, 1 },   // A-Z
+    { 0x00C0, 0x00D6,  32, 1 },   // À-Ö
+    { 0x00D8, 0x00DE,  32, 1 },   // Ø-Þ
+    { 0x0100, 0x012F,   1, 2 },   // Ā-į (upper case on even codepoints)
+    { 0x0132, 0x0137,   1, 2 },
+    { 0x0139, 0x0148,   1, 2 },   // Ĺ-ň (upper case on odd codepoints)
+    { 0x014A, 0x0177,   1, 2 },
+    { 0x0178, 0x0178, -121, 1 },  // Ÿ
+    { 0x0179, 0x017E,   1, 2 },
+    { 0x0391, 0x03A1,  32, 1 },   // Α-Ρ
+    { 0x03A3, 0x03AB,  32, 1 },   // Σ-Ϋ
+    { 0x0400, 0x040F,  80, 1 },   // Ѐ-Џ
+    { 0x0410, 0x042F,  32, 1 },   // А-Я
+};
+
+unsigned int fold_codepoint(unsigned int cp) {
+    int ranges = sizeof(case_fold_ranges) / sizeof(case_fold_ranges[0]);
+    
+    for (int i = 0; i < ranges; i++) {
+        const CaseFoldRange* r = &case_fold_ranges[i];
+        if (cp < r->lo) break;
+        if (cp <= r->hi && (cp - r->lo) % r->stride == 0) {
+            return cp + r->delta;
+        }
+    }
+    return cp;
+}
+
+// Decodes one UTF-8 sequence; malformed bytes decode as themselves (Latin-1)
+int utf8_decode(const char* s, unsigned int* cp) {
+    unsigned char c = (unsigned char)s[0];
+    int len;
+    
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    }
+    
+    if ((c & 0xE0) == 0xC0) { len = 2; *cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { len = 3; *cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { len = 4; *cp = c & 0x07; }
+    else { *cp = c; return 1; }
+    
+    for (int i = 1; i < len; i++) {
+        if (((unsigned char)s[i] & 0xC0) != 0x80) {
+            *cp = c;
+            return 1;
+        }
+        *cp = (*cp << 6) | ((unsigned char)s[i] & 0x3F);
+    }
+    return len;
+}
+
+Alphabet alphabet;
+
+int symbol_of(unsigned int cp) {
+    if (cp < 128) {
+        return alphabet.ascii_slot[cp] ? alphabet.ascii_slot[cp] - 1 : SYMBOL_UNKNOWN;
+    }
+    
+    int lo = 0, hi = alphabet.wide_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (alphabet.wide_codepoint[mid] == cp) return alphabet.wide_id[mid];
+        if (alphabet.wide_codepoint[mid] < cp) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return SYMBOL_UNKNOWN;
+}
+
+// Returns the symbol id for a folded codepoint, adding it if there is room
+int alphabet_add(unsigned int cp) {
+    int id = symbol_of(cp);
+    if (id != SYMBOL_UNKNOWN) return id;
+    if (alphabet.size >= MAX_SYMBOLS) return SYMBOL_UNKNOWN;
+    
+    id = alphabet.size++;
+    alphabet.codepoint[id] = cp;
+    
+    if (cp < 128) {
+        alphabet.ascii_slot[cp] = (unsigned char)(id + 1);
+    } else {
+        int pos = alphabet.wide_count++;
+        while (pos > 0 && alphabet.wide_codepoint[pos - 1] > cp) {
+            alphabet.wide_codepoint[pos] = alphabet.wide_codepoint[pos - 1];
+            alphabet.wide_id[pos] = alphabet.wide_id[pos - 1];
+            pos--;
+        }
+        alphabet.wide_codepoint[pos] = cp;
+        alphabet.wide_id[pos] = (unsigned char)id;
+    }
+    
+    for (int other = 0; other < id; other++) {
+        unsigned int other_cp = alphabet.codepoint[other];
+        double d = (cp < 128 && other_cp < 128) ? keyboard_distance((char)cp, (char)other_cp) : 1.0;
+        alphabet.distance[id][other] = d;
+        alphabet.distance[other][id] = d;
+    }
+    alphabet.distance[id][id] = 0.0;
+    
+    return id;
+}
+
+// Adds every codepoint used by words, in codepoint order
+void alphabet_from_words(char** words, int count) {
+    const unsigned int max_cp = 0x110000;
+    unsigned char* seen = (unsigned char*)calloc(max_cp / 8, 1);
+    
+    for (int w = 0; w < count; w++) {
+        unsigned int cp;
+        for (const char* p = words[w]; *p; ) {
+            p += utf8_decode(p, &cp);
+            cp = fold_codepoint(cp);
+            if (cp < max_cp) seen[cp >> 3] |= (unsigned char)(1 << (cp & 7));
+        }
+    }
+    
+    int dropped = 0;
+    for (unsigned int cp = 0; cp < max_cp; cp++) {
+        if ((seen[cp >> 3] & (1 << (cp & 7))) && alphabet_add(cp) == SYMBOL_UNKNOWN) dropped++;
+    }
+    free(seen);
+    
+    // Characters past MAX_SYMBOLS are dropped from the trie path, so those
+    // words can collide with others; say how many
+    if (dropped > 0) {
+        int affected = 0;
+        for (int w = 0; w < count; w++) {
+            unsigned int cp;
+            for (const char* p = words[w]; *p; ) {
+                p += utf8_decode(p, &cp);
+                if (symbol_of(fold_codepoint(cp)) == SYMBOL_UNKNOWN) {
+                    affected++;
+                    break;
+                }
+            }
+        }
+        printf("Warning: alphabet full (%d symbols); %d characters dropped from %d words\n",
+               MAX_SYMBOLS, dropped, affected);
+    }
+}
+
+void alphabet_learn_word(const char* word) {
+    static int warned = 0;
+    unsigned int cp;
+    for (const char* p = word; *p; ) {
+        p += utf8_decode(p, &cp);
+        if (alphabet_add(fold_codepoint(cp)) == SYMBOL_UNKNOWN && !warned) {
+            printf("Warning: alphabet full (%d symbols); dropping U+%04X and later new characters (first in '%s')\n",
+                   MAX_SYMBOLS, fold_codepoint(cp), word);
+            warned = 1;
+        }
+    }
+}
+
+// Maps a word to its trie path. Symbols outside the alphabet are dropped
+// when building, but kept as SYMBOL_UNKNOWN for lookups and scoring so they
+// can never match.
+int word_key(const char* word, unsigned char* key, int keep_unknown) {
+    int len = 0;
+    unsigned int cp;
+    
+    for (const char* p = word; *p && len < MAX_WORD_LENGTH; ) {
+        int id;
+        unsigned char c = (unsigned char)*p;
+        
+        if (c < 0x80) {
+            if (c >= 'A' && c <= 'Z') c += 32;
+            id = alphabet.ascii_slot[c] ? alphabet.ascii_slot[c] - 1 : SYMBOL_UNKNOWN;
+            p++;
+        } else {
+            p += utf8_decode(p, &cp);
+            id = symbol_of(fold_codepoint(cp));
+        }
+        if (id == SYMBOL_UNKNOWN && !keep_unknown) continue;
+        key[len++] = (unsigned char)id;
+    }
+    return len;
+}
+
+double symbol_distance(unsigned char a, unsigned char b) {
+    if (a == b) return 0.0;
+    if (a >= MAX_SYMBOLS || b >= MAX_SYMBOLS) return 1.0;
+    return alphabet.distance[a][b];
+}
+
 // ==========================================
 // MODULE 3: ENHANCED HEAP OPERATIONS
 // ==========================================
 
-void init_enhanced_heap(EnhancedHeap* heap) {
+void init_enhanced_heap(EnhancedHeap* heap, int capacity) {
     heap->count = 0;
+    heap->capacity = capacity < 1 ? TOP_K : capacity < RERANK_POOL ? capacity : RERANK_POOL;
+}
+
+// Orders results by rank, breaking ties on the word so the kept Top-K does
+// not depend on insertion order (e.g. which shard answered first)
+int result_worse(const EnhancedResult* a, double rank, const char* word) {
+    if (a->rank != rank) return a->rank > rank;
+    return strcmp(a->word, word) > 0;
 }
 
 void add_enhanced_suggestion(EnhancedHeap* heap, char* word, double score, int match_type) {
+    // Keep ranks at the shard wire precision so ties survive the round trip
+    score = lround(score * 1e6) / 1e6;
+    
     // Check for duplicates
     for(int i = 0; i < heap->count; i++) {
         if(strcmp(heap->elements[i].word, word) == 0) {
@@ -111,20 +370,21 @@ void add_enhanced_suggestion(EnhancedHeap* heap, char* word, double score, int m
         }
     }
 
-    if (heap->count < TOP_K) {
+    if (heap->count < heap->capacity) {
         heap->elements[heap->count].word = strdup(word);
         heap->elements[heap->count].rank = score;
         heap->elements[heap->count].match_type = match_type;
         heap->count++;
     } else {
         int worst_idx = 0;
-        for (int i = 1; i < TOP_K; i++) {
-            if (heap->elements[i].rank > heap->elements[worst_idx].rank) {
+        for (int i = 1; i < heap->capacity; i++) {
+            EnhancedResult* worst = &heap->elements[worst_idx];
+            if (result_worse(&heap->elements[i], worst->rank, worst->word)) {
                 worst_idx = i;
             }
         }
         
-        if (score < heap->elements[worst_idx].rank) {
+        if (result_worse(&heap->elements[worst_idx], score, word)) {
             free(heap->elements[worst_idx].word);
             heap->elements[worst_idx].word = strdup(word);
             heap->elements[worst_idx].rank = score;
@@ -136,7 +396,7 @@ void add_enhanced_suggestion(EnhancedHeap* heap, char* word, double score, int m
 void sort_enhanced_heap(EnhancedHeap* heap) {
     for (int i = 0; i < heap->count - 1; i++) {
         for (int j = 0; j < heap->count - i - 1; j++) {
-            if (heap->elements[j].rank > heap->elements[j + 1].rank) {
+            if (result_worse(&heap->elements[j], heap->elements[j + 1].rank, heap->elements[j + 1].word)) {
                 EnhancedResult temp = heap->elements[j];
                 heap->elements[j] = heap->elements[j + 1];
                 heap->elements[j + 1] = temp;
@@ -145,38 +405,166 @@ void sort_enhanced_heap(EnhancedHeap* heap) {
     }
 }
 
+// Keep the best count entries of a sorted heap
+void truncate_enhanced_heap(EnhancedHeap* heap, int count) {
+    while (heap->count > count) {
+        free(heap->elements[--heap->count].word);
+    }
+}
+
 // ==========================================
 // MODULE 4: TRIE OPERATIONS
 // ==========================================
 
+NodePool node_pool = { NULL, 0 };
+
+void* pool_alloc(NodePool* pool, size_t bytes) {
+    bytes = (bytes + 7) & ~(size_t)7;
+    
+    if (!pool->head || pool->head->used + bytes > pool->head->size) {
+        size_t size = bytes > POOL_BLOCK_SIZE ? bytes : POOL_BLOCK_SIZE;
+        PoolBlock* block = (PoolBlock*)calloc(1, sizeof(PoolBlock) + size);
+        block->size = size;
+        block->next = pool->head;
+        pool->head = block;
+        pool->bytes += sizeof(PoolBlock) + size;
+    }
+    
+    void* memory = (char*)(pool->head + 1) + pool->head->used;
+    pool->head->used += bytes;
+    return memory;
+}
+
+TrieNode* pool_alloc_node(NodePool* pool) {
+    return (TrieNode*)pool_alloc(pool, sizeof(TrieNode));
+}
+
+// Hands every block of src over to dst
+void pool_merge(NodePool* dst, NodePool* src) {
+    if (!src->head) return;
+    
+    PoolBlock* tail = src->head;
+    while (tail->next) tail = tail->next;
+    
+    tail->next = dst->head;
+    dst->head = src->head;
+    dst->bytes += src->bytes;
+    src->head = NULL;
+    src->bytes = 0;
+}
+
 TrieNode* create_node() {
-    TrieNode* node = (TrieNode*)malloc(sizeof(TrieNode));
-    node->isEndOfWord = 0;
-    node->word = NULL;
-    for (int i = 0; i < ALPHABET_SIZE; i++) {
-        node->children[i] = NULL;
+    return pool_alloc_node(&node_pool);
+}
+
+int count_bits(unsigned long long x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1) count++;
+    return count;
+#endif
+}
+
+int lowest_bit(unsigned long long x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int bit = 0;
+    while (!(x & 1)) { x >>= 1; bit++; }
+    return bit;
+#endif
+}
+
+int child_capacity(int count) {
+    int capacity = count > 0 ? 1 : 0;
+    while (capacity < count) capacity <<= 1;
+    return capacity;
+}
+
+// Position of symbol's child in the packed children array
+int child_slot(TrieNode* node, int symbol) {
+    int word = symbol >> 6;
+    int slot = count_bits(node->child_bits[word] & ((1ULL << (symbol & 63)) - 1));
+    for (int i = 0; i < word; i++) {
+        slot += count_bits(node->child_bits[i]);
+    }
+    return slot;
+}
+
+TrieNode* get_child(TrieNode* node, int symbol) {
+    if (symbol >= MAX_SYMBOLS) return NULL;
+    if (!(node->child_bits[symbol >> 6] & (1ULL << (symbol & 63)))) return NULL;
+    return node->children[child_slot(node, symbol)];
+}
+
+void attach_child(NodePool* pool, TrieNode* node, int symbol, TrieNode* child) {
+    int slot = child_slot(node, symbol);
+    int count = node->child_count;
+    
+    if (count == child_capacity(count)) {
+        TrieNode** grown = (TrieNode**)pool_alloc(pool, (count > 0 ? count * 2 : 1) * sizeof(TrieNode*));
+        if (count > 0) {
+            memcpy(grown, node->children, slot * sizeof(TrieNode*));
+            memcpy(grown + slot + 1, node->children + slot, (count - slot) * sizeof(TrieNode*));
+        }
+        node->children = grown;
+    } else {
+        memmove(node->children + slot + 1, node->children + slot, (count - slot) * sizeof(TrieNode*));
     }
-    return node;
+    
+    node->children[slot] = child;
+    node->child_bits[symbol >> 6] |= 1ULL << (symbol & 63);
+    node->child_count++;
+}
+
+TrieNode* add_child(NodePool* pool, TrieNode* node, int symbol) {
+    TrieNode* child = pool_alloc_node(pool);
+    attach_child(pool, node, symbol, child);
+    return child;
 }
 
 void insert_word(TrieNode* root, const char* word) {
+    unsigned char key[MAX_WORD_LENGTH];
     TrieNode* curr = root;
     
-    for (int i = 0; word[i] != '\0'; i++) {
-        int index = tolower(word[i]) - 'a';
-        if (index < 0 || index >= 26) continue;
-        
-        if (!curr->children[index]) {
-            curr->children[index] = create_node();
+    alphabet_learn_word(word);
+    int len = word_key(word, key, 0);
+    
+    for (int i = 0; i < len; i++) {
+        TrieNode* next = get_child(curr, key[i]);
+        if (!next) {
+            next = add_child(&node_pool, curr, key[i]);
         }
-        curr = curr->children[index];
+        curr = next;
     }
     
     curr->isEndOfWord = 1;
     curr->word = strdup(word);
 }
 
-void load_dictionary_from_file(TrieNode* root, const char* filename) {
+// FNV-1a over the case-folded codepoints insert_word() keys on, so words
+// sharing a trie path always land on the same shard
+int shard_of(const char* word, int shard_count) {
+    unsigned int hash = 2166136261u;
+    unsigned int cp;
+    
+    for (const char* p = word; *p; ) {
+        p += utf8_decode(p, &cp);
+        cp = fold_codepoint(cp);
+        
+        for (int i = 0; i < 4; i++) {
+            hash ^= (cp >> (8 * i)) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    
+    return (int)(hash % (unsigned int)shard_count);
+}
+
+// Loads only the words that hash to shard_id (shard_count == 1 loads everything)
+void load_dictionary_shard(TrieNode* root, const char* filename, int shard_id, int shard_count) {
     FILE* file = fopen(filename, "r");
     
     if (!file) {
@@ -191,216 +579,723 @@ void load_dictionary_from_file(TrieNode* root, const char* filename) {
         buffer[strcspn(buffer, "\n")] = '\0';
         
         if (strlen(buffer) > 0) {
+            if (shard_count > 1 && shard_of(buffer, shard_count) != shard_id) continue;
             insert_word(root, buffer);
             word_count++;
         }
     }
     
     fclose(file);
-    printf("Dictionary loaded! Total words: %d\n", word_count);
+    if (shard_count > 1) {
+        printf("Shard %d/%d loaded! Words: %d\n", shard_id, shard_count, word_count);
+    } else {
+        printf("Dictionary loaded! Total words: %d\n", word_count);
+    }
 }
 
-TrieNode* find_prefix_node(TrieNode* root, const char* prefix) {
+void load_dictionary_from_file(TrieNode* root, const char* filename) {
+    load_dictionary_shard(root, filename, 0, 1);
+}
+
+TrieNode* find_key_node(TrieNode* root, const unsigned char* key, int len) {
     TrieNode* current = root;
-    int len = strlen(prefix);
     
-    for (int i = 0; i < len; i++) {
-        int index = tolower(prefix[i]) - 'a';
-        if (index < 0 || index >= 26 || !current->children[index]) {
-            return NULL;
-        }
-        current = current->children[index];
+    for (int i = 0; i < len && current; i++) {
+        current = get_child(current, key[i]);
     }
     
     return current;
 }
 
+TrieNode* find_prefix_node(TrieNode* root, const char* prefix) {
+    unsigned char key[MAX_WORD_LENGTH];
+    int len = word_key(prefix, key, 1);
+    return find_key_node(root, key, len);
+}
+
 int word_exists(TrieNode* root, const char* word) {
-    TrieNode* current = root;
-    int len = strlen(word);
-    
-    for (int i = 0; i < len; i++) {
-        int index = tolower(word[i]) - 'a';
-        if (index < 0 || index >= 26 || !current->children[index]) {
-            return 0;
-        }
-        current = current->children[index];
-    }
-    
-    return current->isEndOfWord;
+    unsigned char key[MAX_WORD_LENGTH];
+    int len = word_key(word, key, 1);
+    TrieNode* node = find_key_node(root, key, len);
+    return node && node->isEndOfWord;
 }
 
-// ==========================================
-// MODULE 5: SIMILARITY ALGORITHMS
-// ==========================================
 
-double min3(double a, double b, double c) {
-    double min = a;
-    if (b < min) min = b;
-    if (c < min) min = c;
-    return min;
+// ------------------------------------------
+// Bulk build from a whole dictionary file
+// ------------------------------------------
+//
+// The file is read in one block and split in place; node->word points into
+// that buffer, which lives as long as the trie. Words are checked for trie
+// key order (sorting only if needed), then each top-level subtree is built
+// in a single linear pass that reuses the path shared with the previous
+// word. Subtrees are independent, so they are spread across threads, each
+// drawing nodes from its own slab pool.
+
+long long now_ms() {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
 }
 
-// N-gram similarity
-double ngram_similarity(const char* s1, const char* s2) {
-    int len1 = strlen(s1);
-    int len2 = strlen(s2);
-    
-    if (len1 < 2 || len2 < 2) return 0.0;
+long peak_memory_kb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+int cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+int compare_keys(const unsigned char* key_a, int len_a, const unsigned char* key_b, int len_b) {
+    int cmp = memcmp(key_a, key_b, len_a < len_b ? len_a : len_b);
+    if (cmp != 0) return cmp;
+    return len_a - len_b;
+}
+
+int compare_word_keys(const char* a, const char* b) {
+    unsigned char key_a[MAX_WORD_LENGTH], key_b[MAX_WORD_LENGTH];
+    int len_a = word_key(a, key_a, 0);
+    int len_b = word_key(b, key_b, 0);
+    return compare_keys(key_a, len_a, key_b, len_b);
+}
+
+// Ties keep file order (the buffer is contiguous), so a later duplicate
+// still wins the node just like repeated insert_word() calls
+int compare_word_entries(const void* a, const void* b) {
+    const char* word_a = *(const char* const*)a;
+    const char* word_b = *(const char* const*)b;
+    int cmp = compare_word_keys(word_a, word_b);
+    if (cmp != 0) return cmp;
+    return (word_a > word_b) - (word_a < word_b);
+}
+
+// A word with its trie key computed once: key[0] is the length, followed by
+// the symbols, so sorting compares bytes instead of re-decoding UTF-8
+typedef struct {
+    const unsigned char* key;
+    char* word;
+} KeyedWord;
+
+int compare_keyed_words(const void* a, const void* b) {
+    const KeyedWord* ka = (const KeyedWord*)a;
+    const KeyedWord* kb = (const KeyedWord*)b;
+    int cmp = compare_keys(ka->key + 1, ka->key[0], kb->key + 1, kb->key[0]);
+    if (cmp != 0) return cmp;
+    return (ka->word > kb->word) - (ka->word < kb->word);
+}
+
+// Same order as qsort(words, count, sizeof(char*), compare_word_entries)
+void sort_words_by_key(char** words, int count) {
+    size_t key_bytes = 0;
+    for (int i = 0; i < count; i++) key_bytes += strlen(words[i]) + 1;
+    
+    unsigned char* keys = (unsigned char*)malloc(key_bytes);
+    KeyedWord* keyed = (KeyedWord*)malloc((size_t)count * sizeof(KeyedWord));
+    unsigned char* out = keys;
+    for (int i = 0; i < count; i++) {
+        out[0] = (unsigned char)word_key(words[i], out + 1, 0);
+        keyed[i].key = out;
+        keyed[i].word = words[i];
+        out += out[0] + 1;
+    }
     
-    int bigrams1[26*26] = {0};
-    int bigrams2[26*26] = {0};
-    int count1 = 0, count2 = 0;
+    qsort(keyed, count, sizeof(KeyedWord), compare_keyed_words);
     
-    for (int i = 0; i < len1 - 1; i++) {
-        int c1 = tolower(s1[i]) - 'a';
-        int c2 = tolower(s1[i+1]) - 'a';
-        if (c1 >= 0 && c1 < 26 && c2 >= 0 && c2 < 26) {
-            int idx = c1 * 26 + c2;
-            if (bigrams1[idx] == 0) count1++;
-            bigrams1[idx]++;
-        }
+    for (int i = 0; i < count; i++) words[i] = keyed[i].word;
+    free(keyed);
+    free(keys);
+}
+
+// Packs the children collected for a finished node (already in symbol order)
+void finish_node(TrieNode* node, const unsigned char* symbols, TrieNode** kids, int count, NodePool* pool) {
+    if (count == 0) return;
+    
+    node->children = (TrieNode**)pool_alloc(pool, child_capacity(count) * sizeof(TrieNode*));
+    for (int i = 0; i < count; i++) {
+        node->child_bits[symbols[i] >> 6] |= 1ULL << (symbols[i] & 63);
+        node->children[i] = kids[i];
     }
-    
-    for (int i = 0; i < len2 - 1; i++) {
-        int c1 = tolower(s2[i]) - 'a';
-        int c2 = tolower(s2[i+1]) - 'a';
-        if (c1 >= 0 && c1 < 26 && c2 >= 0 && c2 < 26) {
-            int idx = c1 * 26 + c2;
-            if (bigrams2[idx] == 0) count2++;
-            bigrams2[idx]++;
+    node->child_count = (unsigned char)count;
+}
+
+// Builds the subtree for words[lo..hi), which must be in key order and all
+// start with the same symbol, and returns its top node (depth 1). A node's
+// children are only packed once the sorted walk has left it for good.
+TrieNode* build_sorted_range(char** words, int lo, int hi, NodePool* pool) {
+    TrieNode* path[MAX_WORD_LENGTH + 1];
+    unsigned char prev[MAX_WORD_LENGTH], key[MAX_WORD_LENGTH];
+    int prev_len = 0;
+    
+    unsigned char (*pending_symbols)[MAX_SYMBOLS] = malloc((MAX_WORD_LENGTH + 1) * sizeof(*pending_symbols));
+    TrieNode* (*pending_kids)[MAX_SYMBOLS] = malloc((MAX_WORD_LENGTH + 1) * sizeof(*pending_kids));
+    int pending_count[MAX_WORD_LENGTH + 1];
+    
+    path[1] = pool_alloc_node(pool);
+    pending_count[1] = 0;
+    
+    for (int i = lo; i < hi; i++) {
+        int len = word_key(words[i], key, 0);
+        
+        int shared = 1;
+        if (i > lo) {
+            while (shared < len && shared < prev_len && key[shared] == prev[shared]) {
+                shared++;
+            }
+        }
+        
+        for (int d = prev_len; d > shared; d--) {
+            finish_node(path[d], pending_symbols[d], pending_kids[d], pending_count[d], pool);
+        }
+        
+        for (int d = shared; d < len; d++) {
+            TrieNode* child = pool_alloc_node(pool);
+            pending_symbols[d][pending_count[d]] = key[d];
+            pending_kids[d][pending_count[d]] = child;
+            pending_count[d]++;
+            
+            path[d + 1] = child;
+            pending_count[d + 1] = 0;
         }
+        
+        path[len]->isEndOfWord = 1;
+        path[len]->word = words[i];
+        
+        memcpy(prev, key, len);
+        prev_len = len;
     }
     
-    int intersection = 0;
-    for (int i = 0; i < 26*26; i++) {
-        if (bigrams1[i] > 0 && bigrams2[i] > 0) {
-            intersection++;
-        }
+    for (int d = prev_len; d >= 1; d--) {
+        finish_node(path[d], pending_symbols[d], pending_kids[d], pending_count[d], pool);
     }
     
-    int union_count = count1 + count2 - intersection;
-    return union_count > 0 ? (double)intersection / union_count : 0.0;
+    free(pending_symbols);
+    free(pending_kids);
+    return path[1];
 }
 
-// LCS length
-int lcs_length(const char* s1, const char* s2) {
-    int m = strlen(s1);
-    int n = strlen(s2);
-    
-    int* prev = (int*)calloc(n + 1, sizeof(int));
-    int* curr = (int*)calloc(n + 1, sizeof(int));
+// insert_word() for a word living in the dictionary buffer. Buffer order is
+// file order, so an earlier line never replaces a later duplicate.
+void insert_buffered_word(TrieNode* root, char* word) {
+    unsigned char key[MAX_WORD_LENGTH];
+    int len = word_key(word, key, 0);
+    TrieNode* curr = root;
     
-    for (int i = 1; i <= m; i++) {
-        for (int j = 1; j <= n; j++) {
-            if (tolower(s1[i-1]) == tolower(s2[j-1])) {
-                curr[j] = prev[j-1] + 1;
-            } else {
-                curr[j] = (prev[j] > curr[j-1]) ? prev[j] : curr[j-1];
-            }
+    for (int d = 0; d < len; d++) {
+        TrieNode* next = get_child(curr, key[d]);
+        if (!next) {
+            next = add_child(&node_pool, curr, key[d]);
         }
-        int* temp = prev;
-        prev = curr;
-        curr = temp;
+        curr = next;
     }
     
-    int result = prev[n];
-    free(prev);
-    free(curr);
-    return result;
+    if (!curr->word || curr->word < word) {
+        curr->isEndOfWord = 1;
+        curr->word = word;
+    }
 }
 
-// Damerau-Levenshtein distance
-double damerau_levenshtein(const char* s1, const char* s2) {
-    int len1 = strlen(s1);
-    int len2 = strlen(s2);
-    
-    double** d = (double**)malloc((len1 + 1) * sizeof(double*));
-    for (int i = 0; i <= len1; i++) {
-        d[i] = (double*)malloc((len2 + 1) * sizeof(double));
-    }
-    
-    for (int i = 0; i <= len1; i++) d[i][0] = i;
-    for (int j = 0; j <= len2; j++) d[0][j] = j;
-    
-    for (int i = 1; i <= len1; i++) {
-        for (int j = 1; j <= len2; j++) {
-            double cost = keyboard_distance(s1[i-1], s2[j-1]);
-            
-            d[i][j] = min3(
-                d[i-1][j] + 1.0,
-                d[i][j-1] + 1.0,
-                d[i-1][j-1] + cost
-            );
-            
-            if (i > 1 && j > 1 && 
-                tolower(s1[i-1]) == tolower(s2[j-2]) && 
-                tolower(s1[i-2]) == tolower(s2[j-1])) {
-                double trans_cost = d[i-2][j-2] + keyboard_distance(s1[i-1], s2[j-1]);
-                if (trans_cost < d[i][j]) {
-                    d[i][j] = trans_cost;
-                }
-            }
+typedef struct {
+    TrieNode** bucket_root;  // subtree built for each first symbol
+    char** words;
+    int* bucket_start;       // alphabet.size + 1 offsets into words
+    int thread_id;
+    int thread_count;
+    NodePool pool;
+} BuildTask;
+
+void run_build_task(BuildTask* task) {
+    for (int b = task->thread_id; b < alphabet.size; b += task->thread_count) {
+        int lo = task->bucket_start[b];
+        int hi = task->bucket_start[b + 1];
+        if (lo < hi) {
+            task->bucket_root[b] = build_sorted_range(task->words, lo, hi, &task->pool);
         }
     }
+}
+
+#ifdef _WIN32
+DWORD WINAPI build_thread_main(LPVOID arg) {
+    run_build_task((BuildTask*)arg);
+    return 0;
+}
+#else
+void* build_thread_main(void* arg) {
+    run_build_task((BuildTask*)arg);
+    return NULL;
+}
+#endif
+
+// Reads a whole file in one block, NUL-terminated; NULL if unreadable
+char* read_whole_file(const char* filename, long* size_out) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
     
-    double result = d[len1][len2];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
     
-    for (int i = 0; i <= len1; i++) {
-        free(d[i]);
-    }
-    free(d);
+    char* data = (char*)malloc(size + 1);
+    size_t got = fread(data, 1, size, file);
+    fclose(file);
+    data[got] = '\0';
     
-    return result;
+    *size_out = (long)got;
+    return data;
 }
 
-// ==========================================
-// MODULE 6: TYPO DETECTION & SCORING
-// ==========================================
-
-int count_trailing_repeats(const char* input) {
-    int len = strlen(input);
-    if (len < 2) return 0;
+// Reads the whole file into one buffer and splits it into words in place.
+// Returns the buffer (caller keeps it alive) or NULL if the file is unreadable.
+char* read_word_list(const char* filename, char*** words_out, int* count_out) {
+    long got;
+    char* data = read_whole_file(filename, &got);
+    if (!data) return NULL;
+    
+    int capacity = 1;
+    for (long i = 0; i < got; i++) {
+        if (data[i] == '\n') capacity++;
+    }
     
-    char last_char = tolower(input[len - 1]);
-    int count = 1;
+    char** words = (char**)malloc(capacity * sizeof(char*));
+    int count = 0;
+    char* line = data;
     
-    for (int i = len - 2; i >= 0 && tolower(input[i]) == last_char; i--) {
-        count++;
+    while (*line) {
+        char* end = strchr(line, '\n');
+        char* next = end ? end + 1 : line + strlen(line);
+        if (end) *end = '\0';
+        
+        int len = strlen(line);
+        if (len > 0 && line[len - 1] == '\r') line[--len] = '\0';
+        if (len > 0 && len < MAX_WORD_LENGTH) words[count++] = line;
+        
+        line = next;
     }
     
-    return count;
+    *words_out = words;
+    *count_out = count;
+    return data;
 }
 
-int is_candidate_substring(const char* input, const char* candidate) {
-    int input_len = strlen(input);
-    int cand_len = strlen(candidate);
+// Same result as load_dictionary_shard(), built in bulk
+void bulk_load_dictionary(TrieNode* root, const char* filename, int shard_id, int shard_count) {
+    long long start = now_ms();
+    char** words;
+    int count;
     
-    if (cand_len > input_len) return 0;
+    char* data = read_word_list(filename, &words, &count);
+    if (!data) {
+        printf("Error: Could not open file '%s'\n", filename);
+        return;
+    }
+    
+    // Every shard derives the same alphabet from the full list
+    alphabet_from_words(words, count);
+    
+    if (shard_count > 1) {
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (shard_of(words[i], shard_count) == shard_id) words[kept++] = words[i];
+        }
+        count = kept;
+    }
+    
+    // Nearly sorted input (allword.txt has a few capitalised words out of key
+    // order) keeps its sorted run; the stragglers are inserted one by one
+    // afterwards. Anything more disordered than that is simply sorted.
+    // keys[0] / keys[1] hold the keys of the last two words of the run.
+    char** stragglers = (char**)malloc((count + 1) * sizeof(char*));
+    int straggler_count = 0;
+    int max_stragglers = count / 64;
+    int in_order = 0;
+    int scanned = 0;
+    unsigned char keys[3][MAX_WORD_LENGTH];
+    unsigned char* last = keys[0];
+    unsigned char* before_last = keys[1];
+    unsigned char* current = keys[2];
+    int last_len = 0, before_last_len = 0;
+    
+    for (; scanned < count && straggler_count <= max_stragglers; scanned++) {
+        char* word = words[scanned];
+        int len = word_key(word, current, 0);
+        
+        if (in_order > 0 && compare_keys(last, last_len, current, len) > 0) {
+            // Either word dips below the run, or the previous word was a spike
+            if (in_order > 1 && compare_keys(before_last, before_last_len, current, len) <= 0) {
+                stragglers[straggler_count++] = words[--in_order];
+                words[in_order++] = word;
+                unsigned char* spare = last;
+                last = current;
+                last_len = len;
+                current = spare;
+            } else {
+                stragglers[straggler_count++] = word;
+            }
+        } else {
+            words[in_order++] = word;
+            unsigned char* spare = before_last;
+            before_last = last;
+            before_last_len = last_len;
+            last = current;
+            last_len = len;
+            current = spare;
+        }
+    }
+    
+    char order[64];
+    if (straggler_count <= max_stragglers) {
+        sprintf(order, "sorted input, %d out of order", straggler_count);
+    } else {
+        sprintf(order, "unsorted input, over %d out of order", max_stragglers);
+    }
+    
+    int sorted = straggler_count <= max_stragglers;
+    if (sorted) {
+        count = in_order;
+    } else {
+        // The scan stopped early; the unscanned tail is still in place after
+        // the run and its stragglers, and gets sorted with them
+        memcpy(words + in_order, stragglers, straggler_count * sizeof(char*));
+        sort_words_by_key(words, count);
+        straggler_count = 0;
+    }
+    
+    // Words whose key is empty end on the root itself
+    int first = 0;
+    unsigned char key[MAX_WORD_LENGTH];
+    while (first < count && word_key(words[first], key, 0) == 0) {
+        root->isEndOfWord = 1;
+        root->word = words[first++];
+    }
+    
+    int bucket_start[MAX_SYMBOLS + 1];
+    TrieNode* bucket_root[MAX_SYMBOLS] = { NULL };
+    int pos = first;
+    for (int b = 0; b < alphabet.size; b++) {
+        bucket_start[b] = pos;
+        while (pos < count && word_key(words[pos], key, 0) > 0 && key[0] == b) pos++;
+    }
+    bucket_start[alphabet.size] = pos;
+    
+    int thread_count = cpu_count();
+    if (thread_count > alphabet.size) thread_count = alphabet.size;
+    if (thread_count < 1) thread_count = 1;
+    
+    BuildTask* tasks = (BuildTask*)calloc(thread_count, sizeof(BuildTask));
+    for (int t = 0; t < thread_count; t++) {
+        tasks[t].bucket_root = bucket_root;
+        tasks[t].words = words;
+        tasks[t].bucket_start = bucket_start;
+        tasks[t].thread_id = t;
+        tasks[t].thread_count = thread_count;
+    }
+    
+#ifdef _WIN32
+    HANDLE* threads = (HANDLE*)malloc(thread_count * sizeof(HANDLE));
+    for (int t = 1; t < thread_count; t++) {
+        threads[t] = CreateThread(NULL, 0, build_thread_main, &tasks[t], 0, NULL);
+    }
+    run_build_task(&tasks[0]);
+    for (int t = 1; t < thread_count; t++) {
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+    }
+#else
+    pthread_t* threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    for (int t = 1; t < thread_count; t++) {
+        pthread_create(&threads[t], NULL, build_thread_main, &tasks[t]);
+    }
+    run_build_task(&tasks[0]);
+    for (int t = 1; t < thread_count; t++) {
+        pthread_join(threads[t], NULL);
+    }
+#endif
+    free(threads);
+    
+    for (int t = 0; t < thread_count; t++) {
+        pool_merge(&node_pool, &tasks[t].pool);
+    }
+    free(tasks);
+    
+    for (int b = 0; b < alphabet.size; b++) {
+        if (bucket_root[b]) attach_child(&node_pool, root, b, bucket_root[b]);
+    }
+    
+    for (int i = 0; i < straggler_count; i++) {
+        insert_buffered_word(root, stragglers[i]);
+    }
+    count += straggler_count;
+    free(stragglers);
+    free(words);
+    
+    long long elapsed = now_ms() - start;
+    
+    if (shard_count > 1) {
+        printf("Shard %d/%d loaded! Words: %d\n", shard_id, shard_count, count);
+    } else {
+        printf("Dictionary loaded! Total words: %d\n", count);
+    }
+    printf("Alphabet: %d symbols\n", alphabet.size);
+    printf("Built in %lld ms (%s, %d threads): %.1f MB of nodes, peak memory %.1f MB\n",
+           elapsed, order, thread_count,
+           node_pool.bytes / (1024.0 * 1024.0), peak_memory_kb() / 1024.0);
+}
+
+// Writes `count` distinct, sorted synthetic words (lowercased dictionary
+// words with base-26 letter suffixes) for exercising the bulk build at scale.
+// Lowercasing merges some words, so rounds continue until count are unique.
+int generate_word_list(const char* dictionary, int count, const char* out_filename) {
+    char** words;
+    int dict_count;
+    char* data = read_word_list(dictionary, &words, &dict_count);
+    if (!data || dict_count == 0) {
+        printf("Error: Could not open file '%s'\n", dictionary);
+        return 0;
+    }
+    
+    // Sorting is by trie key, which needs the alphabet
+    alphabet_from_words(words, dict_count);
+    
+    char** generated = (char**)malloc((size_t)count * sizeof(char*));
+    char** blocks = NULL;
+    int block_count = 0;
+    int unique = 0;
+    long long next = 0;
+    
+    while (unique < count) {
+        int need = count - unique;
+        char* storage = (char*)malloc((size_t)need * MAX_WORD_LENGTH);
+        blocks = (char**)realloc(blocks, (block_count + 1) * sizeof(char*));
+        blocks[block_count++] = storage;
+        
+        for (int i = 0; i < need; i++, next++) {
+            char* out = storage + (size_t)i * MAX_WORD_LENGTH;
+            const char* base = words[next % dict_count];
+            int len = 0;
+            
+            while (base[len] && len < MAX_WORD_LENGTH - 4) {
+                out[len] = (char)tolower((unsigned char)base[len]);
+                len++;
+            }
+            for (long long suffix = next / dict_count; suffix > 0 && len < MAX_WORD_LENGTH - 1; suffix = (suffix - 1) / 26) {
+                out[len++] = 'a' + (suffix - 1) % 26;
+            }
+            out[len] = '\0';
+            generated[unique + i] = out;
+        }
+        
+        sort_words_by_key(generated, unique + need);
+        
+        int kept = 0;
+        for (int i = 0; i < unique + need; i++) {
+            if (kept > 0 && strcmp(generated[kept - 1], generated[i]) == 0) continue;
+            generated[kept++] = generated[i];
+        }
+        unique = kept;
+    }
+    
+    FILE* file = fopen(out_filename, "w");
+    if (!file) {
+        printf("Error: Could not write file '%s'\n", out_filename);
+        return 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%s\n", generated[i]);
+    }
+    fclose(file);
+    
+    printf("Wrote %d words to %s\n", count, out_filename);
+    
+    free(generated);
+    for (int b = 0; b < block_count; b++) free(blocks[b]);
+    free(blocks);
+    free(words);
+    free(data);
+    return 1;
+}
+
+// ==========================================
+// MODULE 5: SIMILARITY ALGORITHMS
+// ==========================================
+
+double min3(double a, double b, double c) {
+    double min = a;
+    if (b < min) min = b;
+    if (c < min) min = c;
+    return min;
+}
+
+// Distinct symbol bigrams of s, sorted; returns how many
+int collect_bigrams(const unsigned char* s, int len, int* grams) {
+    int count = 0;
+    
+    for (int i = 0; i < len - 1; i++) {
+        int gram = s[i] * 256 + s[i+1];
+        int pos = count;
+        while (pos > 0 && grams[pos-1] > gram) pos--;
+        if (pos > 0 && grams[pos-1] == gram) continue;
+        
+        memmove(grams + pos + 1, grams + pos, (count - pos) * sizeof(int));
+        grams[pos] = gram;
+        count++;
+    }
+    return count;
+}
+
+// N-gram similarity
+double ngram_similarity(const unsigned char* s1, int len1, const unsigned char* s2, int len2) {
+    if (len1 < 2 || len2 < 2) return 0.0;
+    
+    int bigrams1[MAX_WORD_LENGTH];
+    int bigrams2[MAX_WORD_LENGTH];
+    int count1 = collect_bigrams(s1, len1, bigrams1);
+    int count2 = collect_bigrams(s2, len2, bigrams2);
+    
+    int intersection = 0;
+    for (int i = 0, j = 0; i < count1 && j < count2; ) {
+        if (bigrams1[i] == bigrams2[j]) {
+            intersection++;
+            i++;
+            j++;
+        } else if (bigrams1[i] < bigrams2[j]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+    
+    int union_count = count1 + count2 - intersection;
+    return union_count > 0 ? (double)intersection / union_count : 0.0;
+}
+
+// LCS length
+int lcs_length(const unsigned char* s1, int m, const unsigned char* s2, int n) {
+    int* prev = (int*)calloc(n + 1, sizeof(int));
+    int* curr = (int*)calloc(n + 1, sizeof(int));
+    
+    for (int i = 1; i <= m; i++) {
+        for (int j = 1; j <= n; j++) {
+            if (s1[i-1] == s2[j-1]) {
+                curr[j] = prev[j-1] + 1;
+            } else {
+                curr[j] = (prev[j] > curr[j-1]) ? prev[j] : curr[j-1];
+            }
+        }
+        int* temp = prev;
+        prev = curr;
+        curr = temp;
+    }
+    
+    int result = prev[n];
+    free(prev);
+    free(curr);
+    return result;
+}
+
+// Damerau-Levenshtein distance
+double damerau_levenshtein(const unsigned char* s1, int len1, const unsigned char* s2, int len2) {
+    double** d = (double**)malloc((len1 + 1) * sizeof(double*));
+    for (int i = 0; i <= len1; i++) {
+        d[i] = (double*)malloc((len2 + 1) * sizeof(double));
+    }
+    
+    for (int i = 0; i <= len1; i++) d[i][0] = i;
+    for (int j = 0; j <= len2; j++) d[0][j] = j;
+    
+    for (int i = 1; i <= len1; i++) {
+        for (int j = 1; j <= len2; j++) {
+            double cost = symbol_distance(s1[i-1], s2[j-1]);
+            
+            d[i][j] = min3(
+                d[i-1][j] + 1.0,
+                d[i][j-1] + 1.0,
+                d[i-1][j-1] + cost
+            );
+            
+            if (i > 1 && j > 1 && 
+                s1[i-1] == s2[j-2] && 
+                s1[i-2] == s2[j-1]) {
+                double trans_cost = d[i-2][j-2] + symbol_distance(s1[i-1], s2[j-1]);
+                if (trans_cost < d[i][j]) {
+                    d[i][j] = trans_cost;
+                }
+            }
+        }
+    }
+    
+    double result = d[len1][len2];
+    
+    for (int i = 0; i <= len1; i++) {
+        free(d[i]);
+    }
+    free(d);
+    
+    return result;
+}
+
+// ==========================================
+// MODULE 6: TYPO DETECTION & SCORING
+// ==========================================
+
+int count_trailing_repeats(const unsigned char* input, int len) {
+    if (len < 2) return 0;
+    
+    unsigned char last_char = input[len - 1];
+    int count = 1;
+    
+    for (int i = len - 2; i >= 0 && input[i] == last_char; i--) {
+        count++;
+    }
+    
+    return count;
+}
+
+int is_candidate_substring(const unsigned char* input, int input_len,
+                           const unsigned char* candidate, int cand_len) {
+    if (cand_len > input_len) return 0;
     
     int j = 0;
     for (int i = 0; i < input_len && j < cand_len; i++) {
-        if (tolower(input[i]) == tolower(candidate[j])) {
+        if (input[i] == candidate[j]) {
             j++;
         }
     }
     return (j == cand_len);
 }
 
-double calculate_composite_score(const char* input, const char* candidate) {
-    int input_len = strlen(input);
-    int cand_len = strlen(candidate);
-    
+// Input and candidate are symbol keys, so case is already folded; accented
+// letters are distinct symbols and substitute at full cost
+double calculate_composite_score(const unsigned char* input, int input_len,
+                                 const unsigned char* candidate, int cand_len) {
     // 1. Edit distance
-    double edit_dist = damerau_levenshtein(input, candidate);
+    double edit_dist = damerau_levenshtein(input, input_len, candidate, cand_len);
     double normalized_edit = edit_dist / (double)(input_len > cand_len ? input_len : cand_len);
     
     // 2. N-gram similarity
-    double ngram_sim = ngram_similarity(input, candidate);
+    double ngram_sim = ngram_similarity(input, input_len, candidate, cand_len);
     double ngram_score = 1.0 - ngram_sim;
     
     // 3. LCS
-    int lcs = lcs_length(input, candidate);
+    int lcs = lcs_length(input, input_len, candidate, cand_len);
     double lcs_ratio = (double)lcs / (double)(input_len > cand_len ? input_len : cand_len);
     double lcs_score = 1.0 - lcs_ratio;
     
@@ -410,17 +1305,11 @@ double calculate_composite_score(const char* input, const char* candidate) {
     
     // CRITICAL: Handle trailing repeated characters
     if (input_len > cand_len) {
-        int trailing_repeats = count_trailing_repeats(input);
-        if (trailing_repeats > 1 && len_diff <= trailing_repeats) {
-            char* trimmed = (char*)malloc(input_len);
-            strncpy(trimmed, input, input_len - len_diff);
-            trimmed[input_len - len_diff] = '\0';
-            
-            if (strcasecmp(trimmed, candidate) == 0) {
-                len_penalty *= 0.1;
-                normalized_edit *= 0.2;
-            }
-            free(trimmed);
+        int trailing_repeats = count_trailing_repeats(input, input_len);
+        if (trailing_repeats > 1 && len_diff <= trailing_repeats &&
+            memcmp(input, candidate, cand_len) == 0) {
+            len_penalty *= 0.1;
+            normalized_edit *= 0.2;
         }
     }
     
@@ -430,7 +1319,7 @@ double calculate_composite_score(const char* input, const char* candidate) {
     int max_check = (input_len < cand_len) ? input_len : cand_len;
     
     for (int i = 0; i < max_check; i++) {
-        if (tolower(input[i]) == tolower(candidate[i])) {
+        if (input[i] == candidate[i]) {
             prefix_match_len++;
         } else {
             break;
@@ -448,23 +1337,16 @@ double calculate_composite_score(const char* input, const char* candidate) {
     
     // 6. Substring bonus
     double substring_bonus = 0.0;
-    if (is_candidate_substring(input, candidate)) {
+    if (is_candidate_substring(input, input_len, candidate, cand_len)) {
         substring_bonus = -0.3;
     }
     
     // 7. Trailing typo bonus
     double trailing_typo_bonus = 0.0;
     if (input_len > cand_len) {
-        int trailing_repeats = count_trailing_repeats(input);
-        if (trailing_repeats >= 2) {
-            char* input_trimmed = (char*)malloc(cand_len + 1);
-            strncpy(input_trimmed, input, cand_len);
-            input_trimmed[cand_len] = '\0';
-            
-            if (strcasecmp(input_trimmed, candidate) == 0) {
-                trailing_typo_bonus = -0.5;
-            }
-            free(input_trimmed);
+        int trailing_repeats = count_trailing_repeats(input, input_len);
+        if (trailing_repeats >= 2 && memcmp(input, candidate, cand_len) == 0) {
+            trailing_typo_bonus = -0.5;
         }
     }
     
@@ -481,34 +1363,34 @@ double calculate_composite_score(const char* input, const char* candidate) {
     return score;
 }
 
-void generate_typo_variations(const char* input, char variations[][MAX_WORD_LENGTH], int* var_count) {
+void generate_typo_variations(const unsigned char* input, int len,
+                              unsigned char variations[][MAX_WORD_LENGTH], int* var_lens, int* var_count) {
     *var_count = 0;
-    int len = strlen(input);
     
     // Remove last character
     if (len > 1) {
-        strcpy(variations[*var_count], input);
-        variations[*var_count][len - 1] = '\0';
+        memcpy(variations[*var_count], input, len);
+        var_lens[*var_count] = len - 1;
         (*var_count)++;
     }
     
     // Remove repeated trailing characters
-    if (len > 2 && tolower(input[len-1]) == tolower(input[len-2])) {
-        strcpy(variations[*var_count], input);
+    if (len > 2 && input[len-1] == input[len-2]) {
+        memcpy(variations[*var_count], input, len);
         int trim_pos = len - 1;
-        char last = tolower(input[len-1]);
+        unsigned char last = input[len-1];
         
-        while (trim_pos > 0 && tolower(variations[*var_count][trim_pos-1]) == last) {
+        while (trim_pos > 0 && variations[*var_count][trim_pos-1] == last) {
             trim_pos--;
         }
-        variations[*var_count][trim_pos] = '\0';
+        var_lens[*var_count] = trim_pos;
         (*var_count)++;
     }
     
     // Remove last 2 characters
     if (len > 2) {
-        strcpy(variations[*var_count], input);
-        variations[*var_count][len - 2] = '\0';
+        memcpy(variations[*var_count], input, len);
+        var_lens[*var_count] = len - 2;
         (*var_count)++;
     }
 }
@@ -517,21 +1399,26 @@ void generate_typo_variations(const char* input, char variations[][MAX_WORD_LENG
 // MODULE 7: TRIE TRAVERSAL & SEARCH
 // ==========================================
 
-void traverse_and_score(TrieNode* node, const char* input, EnhancedHeap* results, 
+// path[0..depth) holds the symbols leading to node, i.e. its word's key
+void traverse_and_score(TrieNode* node, const unsigned char* input, int input_len,
+                       unsigned char* path, int depth, EnhancedHeap* results,
                        double max_score_threshold) {
     if (!node) return;
     
-    if (node->isEndOfWord && node->word) {
-        double score = calculate_composite_score(input, node->word);
+    if (node->isEndOfWord && node->word && depth > 0) {
+        double score = calculate_composite_score(input, input_len, path, depth);
         
         if (score < max_score_threshold) {
             add_enhanced_suggestion(results, node->word, score, 2);
         }
     }
     
-    for (int i = 0; i < ALPHABET_SIZE; i++) {
-        if (node->children[i]) {
-            traverse_and_score(node->children[i], input, results, max_score_threshold);
+    int slot = 0;
+    for (int w = 0; w < CHILD_BITMAP_WORDS; w++) {
+        for (unsigned long long bits = node->child_bits[w]; bits; bits &= bits - 1) {
+            path[depth] = (unsigned char)(w * 64 + lowest_bit(bits));
+            traverse_and_score(node->children[slot++], input, input_len, path, depth + 1,
+                               results, max_score_threshold);
         }
     }
 }
@@ -546,182 +1433,1545 @@ void collect_prefix_words(TrieNode* node, EnhancedHeap* results, int depth, int
         add_enhanced_suggestion(results, node->word, rank, 1);
     }
     
-    for (int i = 0; i < ALPHABET_SIZE; i++) {
-        if (node->children[i]) {
-            collect_prefix_words(node->children[i], results, depth + 1, max_depth);
-        }
+    for (int i = 0; i < node->child_count; i++) {
+        collect_prefix_words(node->children[i], results, depth + 1, max_depth);
     }
 }
 
-void get_enhanced_suggestions(TrieNode* root, const char* input, EnhancedHeap* results) {
-    init_enhanced_heap(results);
+void get_enhanced_suggestions(TrieNode* root, const char* input, EnhancedHeap* results, int capacity) {
+    init_enhanced_heap(results, capacity);
     
-    int input_len = strlen(input);
+    unsigned char key[MAX_WORD_LENGTH];
+    int input_len = word_key(input, key, 1);
     if (input_len == 0) return;
     
     // Strategy 0: Check common typo patterns first
-    char variations[10][MAX_WORD_LENGTH];
+    unsigned char variations[10][MAX_WORD_LENGTH];
+    int var_lens[10];
     int var_count;
-    generate_typo_variations(input, variations, &var_count);
+    generate_typo_variations(key, input_len, variations, var_lens, &var_count);
     
     for (int i = 0; i < var_count; i++) {
-        if (word_exists(root, variations[i])) {
-            add_enhanced_suggestion(results, variations[i], 0.001 * (i+1), 0);
+        TrieNode* node = find_key_node(root, variations[i], var_lens[i]);
+        if (node && node->isEndOfWord) {
+            add_enhanced_suggestion(results, node->word, 0.001 * (i+1), 0);
         }
     }
     
     // Strategy 1: Exact prefix matches
-    TrieNode* prefix_node = find_prefix_node(root, input);
+    TrieNode* prefix_node = find_key_node(root, key, input_len);
     if (prefix_node) {
         collect_prefix_words(prefix_node, results, 0, 8);
     }
     
     // Strategy 2: Fuzzy matching
+    unsigned char path[MAX_WORD_LENGTH];
     double threshold = 0.65 + (input_len < 4 ? 0.15 : 0.0);
-    traverse_and_score(root, input, results, threshold);
+    traverse_and_score(root, key, input_len, path, 0, results, threshold);
     
     sort_enhanced_heap(results);
 }
 
 // ==========================================
-// MODULE 8: HTTP SERVER
+// MODULE 8: SHARDED DEPLOYMENT
 // ==========================================
+//
+// The dictionary is hash-partitioned (shard_of) across N shard processes,
+// each running the normal engine over its slice and listening on
+// 127.0.0.1:(base_port + shard_id). The HTTP coordinator fans every query
+// out to all shards and merges their Top-K by (rank, word). Ranks only
+// depend on (input, candidate) and ties break on the word, so when every
+// shard answers the merged Top-K equals the single-process one.
+//
+// Binary shard protocol (one query per connection):
+//   request:  'Q' | u8 k | u8 len | len bytes of word
+//   response: 'R' | u8 count | count x { u8 match_type | u8 len |
+//                                        i32 rank * 1e6 (big-endian) | len bytes }
 
-char* create_json_response(EnhancedHeap* heap) {
-    static char response[2048];
-    strcpy(response, "{\"suggestions\":[");
-    
-    for (int i = 0; i < heap->count; i++) {
-        strcat(response, "\"");
-        strcat(response, heap->elements[i].word);
-        strcat(response, "\"");
-        if (i < heap->count - 1) {
-            strcat(response, ",");
-        }
-    }
-    strcat(response, "]}");
-    
-    return response;
-}
+#define SHARD_RESPONSE_MAX (2 + RERANK_POOL * (6 + 255))
 
-char* extract_query_param(const char* request, const char* param) {
-    static char value[256];
-    const char* pos = strstr(request, param);
-    if (!pos) return NULL;
-    
-    pos += strlen(param) + 1;
-    const char* start = pos;
-    while (*pos && *pos != ' ' && *pos != '&' && *pos != '\r') {
-        pos++;
+typedef struct {
+    int shard_count;
+    int base_port;
+    int deadline_ms;
+} ShardCluster;
+
+int send_all(SOCKET s, const char* data, int len) {
+    int sent = 0;
+    while (sent < len) {
+        int n = send(s, data + sent, len - sent, 0);
+        if (n <= 0) return 0;
+        sent += n;
     }
-    
-    int len = pos - start;
-    strncpy(value, start, len);
-    value[len] = '\0';
-    
-    return value;
+    return 1;
 }
 
-const char* http_response_template = 
-    "HTTP/1.1 200 OK\r\n"
-    "Content-Type: application/json\r\n"
-    "Access-Control-Allow-Origin: *\r\n"
-    "Connection: close\r\n"
-    "\r\n"
-    "%s";
-
-void handle_request(SOCKET client_socket, TrieNode* root) {
-    char buffer[2048];
-    recv(client_socket, buffer, sizeof(buffer)-1, 0);
-    buffer[sizeof(buffer)-1] = '\0';
-    
-    if (strstr(buffer, "GET /suggest?") != NULL) {
-        char* word = extract_query_param(buffer, "word");
-        if (word && strlen(word) > 0) {
-            EnhancedHeap suggestions;
-            get_enhanced_suggestions(root, word, &suggestions);
-            
-            char* json_response = create_json_response(&suggestions);
-            
-            char full_response[4096];
-            sprintf(full_response, http_response_template, json_response);
-            send(client_socket, full_response, strlen(full_response), 0);
-            
-            for (int i = 0; i < suggestions.count; i++) {
-                free(suggestions.elements[i].word);
-            }
-        } else {
-            const char* bad_req = "HTTP/1.1 400 Bad Request\r\n\r\n{\"error\":\"Missing word\"}";
-            send(client_socket, bad_req, strlen(bad_req), 0);
-        }
-    } else {
-        const char* not_found = "HTTP/1.1 404 Not Found\r\n\r\n{\"error\":\"Not found\"}";
-        send(client_socket, not_found, strlen(not_found), 0);
+int recv_all(SOCKET s, char* data, int len) {
+    int got = 0;
+    while (got < len) {
+        int n = recv(s, data + got, len - got, 0);
+        if (n <= 0) return 0;
+        got += n;
     }
+    return 1;
 }
 
-void start_server(TrieNode* root) {
-    WSADATA wsaData;
-    SOCKET server_fd, new_socket;
+SOCKET open_listener(unsigned long bind_addr, int port) {
+    SOCKET server_fd;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
     
+#ifdef _WIN32
+    WSADATA wsaData;
     WSAStartup(MAKEWORD(2,2), &wsaData);
+#endif
     
     if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == INVALID_SOCKET) {
         printf("Socket creation failed\n");
-        return;
+        return INVALID_SOCKET;
     }
     
     if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) == SOCKET_ERROR) {
         printf("Setsockopt failed\n");
-        return;
+        closesocket(server_fd);
+        return INVALID_SOCKET;
     }
     
     address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(8080);
+    address.sin_addr.s_addr = bind_addr;
+    address.sin_port = htons(port);
     
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) == SOCKET_ERROR) {
-        printf("Bind failed\n");
-        return;
+        printf("Bind failed on port %d\n", port);
+        closesocket(server_fd);
+        return INVALID_SOCKET;
     }
     
     if (listen(server_fd, 10) == SOCKET_ERROR) {
         printf("Listen failed\n");
-        return;
+        closesocket(server_fd);
+        return INVALID_SOCKET;
     }
     
-    printf("Server listening on http://localhost:8080/suggest?word=yourword\n");
+    return server_fd;
+}
+
+int encode_shard_response(EnhancedHeap* heap, unsigned char* out) {
+    int pos = 0;
+    out[pos++] = 'R';
+    out[pos++] = (unsigned char)heap->count;
     
-    while (1) {
-        if ((new_socket = accept(server_fd, (struct sockaddr *)&address, &addrlen)) != INVALID_SOCKET) {
-            handle_request(new_socket, root);
-            closesocket(new_socket);
-        }
+    for (int i = 0; i < heap->count; i++) {
+        int len = strlen(heap->elements[i].word);
+        if (len > 255) len = 255;
+        
+        unsigned int rank = htonl((unsigned int)(int)lround(heap->elements[i].rank * 1e6));
+        out[pos++] = (unsigned char)heap->elements[i].match_type;
+        out[pos++] = (unsigned char)len;
+        memcpy(out + pos, &rank, 4);
+        pos += 4;
+        memcpy(out + pos, heap->elements[i].word, len);
+        pos += len;
     }
     
-    closesocket(server_fd);
-    WSACleanup();
+    return pos;
 }
 
-// ==========================================
-// MODULE 9: MAIN
-// ==========================================
-
-int main() {
-    printf("========================================\n");
-    printf("   ENHANCED SPELL CHECKER v2.0\n");
-    printf("========================================\n\n");
+// Returns 1 once a full response has been merged into results, 0 if more
+// bytes are needed, -1 if the shard sent garbage
+int decode_shard_response(const unsigned char* buf, int len, EnhancedHeap* results) {
+    if (len < 2) return 0;
+    if (buf[0] != 'R') return -1;
     
-    TrieNode* root = create_node();
+    int count = buf[1];
+    int pos = 2;
+    for (int i = 0; i < count; i++) {
+        if (pos + 6 > len || pos + 6 + buf[pos + 1] > len) return 0;
+        pos += 6 + buf[pos + 1];
+    }
     
-    printf("Loading dictionary...\n");
-    load_dictionary_from_file(root, "allword.txt");
-    printf("\n");
+    pos = 2;
+    for (int i = 0; i < count; i++) {
+        int match_type = buf[pos];
+        int word_len = buf[pos + 1];
+        unsigned int rank;
+        char word[256];
+        
+        memcpy(&rank, buf + pos + 2, 4);
+        memcpy(word, buf + pos + 6, word_len);
+        word[word_len] = '\0';
+        
+        add_enhanced_suggestion(results, word, (int)ntohl(rank) / 1e6, match_type);
+        pos += 6 + word_len;
+    }
+    
+    return 1;
+}
+
+// The coordinator sends nothing after its request, so once the request has
+// been read the socket only turns readable when the coordinator hung up
+int peer_closed(SOCKET s) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(s, &readable);
+    
+    struct timeval tv = {0, 0};
+    return select((int)s + 1, &readable, NULL, NULL, &tv) > 0;
+}
+
+void handle_shard_request(SOCKET client_socket, TrieNode* root) {
+    unsigned char header[3];
+    char word[256];
+    
+    if (!recv_all(client_socket, (char*)header, 3) || header[0] != 'Q') return;
+    if (!recv_all(client_socket, word, header[2])) return;
+    word[header[2]] = '\0';
+    
+    // Queries the coordinator already gave up on sit in the accept queue
+    // behind the slow one; skip them instead of falling further behind
+    if (peer_closed(client_socket)) return;
+    
+    // Long inputs are capped by word_key(), same as in standalone mode
+    EnhancedHeap suggestions;
+    if (header[2] > 0) {
+        get_enhanced_suggestions(root, word, &suggestions, header[1]);
+    } else {
+        init_enhanced_heap(&suggestions, header[1]);
+    }
+    
+    unsigned char response[SHARD_RESPONSE_MAX];
+    int len = encode_shard_response(&suggestions, response);
+    send_all(client_socket, (char*)response, len);
+    
+    for (int i = 0; i < suggestions.count; i++) {
+        free(suggestions.elements[i].word);
+    }
+}
+
+void start_shard_server(TrieNode* root, int port) {
+    struct sockaddr_in address;
+    socklen_t addrlen = sizeof(address);
+    
+    SOCKET server_fd = open_listener(htonl(INADDR_LOOPBACK), port);
+    if (server_fd == INVALID_SOCKET) return;
+    
+    printf("Shard listening on 127.0.0.1:%d\n", port);
+    
+    while (1) {
+        SOCKET new_socket = accept(server_fd, (struct sockaddr *)&address, &addrlen);
+        if (new_socket != INVALID_SOCKET) {
+            handle_shard_request(new_socket, root);
+            closesocket(new_socket);
+        }
+    }
+    
+    closesocket(server_fd);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+// Scatter the query to every shard, then gather whatever arrives before
+// the deadline. A slow or dead shard only costs its share of the results.
+// Returns the number of shards that answered.
+int gather_shard_suggestions(ShardCluster* cluster, const char* input, EnhancedHeap* results, int capacity) {
+    SOCKET socks[MAX_SHARDS];
+    unsigned char buffers[MAX_SHARDS][SHARD_RESPONSE_MAX];
+    int received[MAX_SHARDS];
+    int pending = 0;
+    int answered = 0;
+    
+    init_enhanced_heap(results, capacity);
+    
+    int input_len = strlen(input);
+    if (input_len == 0 || input_len > 255) return 0;
+    
+    char request[3 + 255];
+    request[0] = 'Q';
+    request[1] = (char)results->capacity;
+    request[2] = (char)input_len;
+    memcpy(request + 3, input, input_len);
+    
+    for (int i = 0; i < cluster->shard_count; i++) {
+        struct sockaddr_in address;
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(cluster->base_port + i);
+        
+        received[i] = 0;
+        socks[i] = socket(AF_INET, SOCK_STREAM, 0);
+        if (socks[i] == INVALID_SOCKET) continue;
+        
+        if (connect(socks[i], (struct sockaddr *)&address, sizeof(address)) == SOCKET_ERROR ||
+            !send_all(socks[i], request, 3 + input_len)) {
+            printf("Shard %d unreachable\n", i);
+            closesocket(socks[i]);
+            socks[i] = INVALID_SOCKET;
+            continue;
+        }
+        pending++;
+    }
+    
+    long long deadline = now_ms() + cluster->deadline_ms;
+    
+    while (pending > 0) {
+        long long remaining = deadline - now_ms();
+        if (remaining <= 0) break;
+        
+        fd_set readable;
+        FD_ZERO(&readable);
+        SOCKET max_fd = 0;
+        for (int i = 0; i < cluster->shard_count; i++) {
+            if (socks[i] == INVALID_SOCKET) continue;
+            FD_SET(socks[i], &readable);
+            if (socks[i] > max_fd) max_fd = socks[i];
+        }
+        
+        struct timeval tv;
+        tv.tv_sec = (long)(remaining / 1000);
+        tv.tv_usec = (long)(remaining % 1000) * 1000;
+        
+        if (select((int)max_fd + 1, &readable, NULL, NULL, &tv) <= 0) continue;
+        
+        for (int i = 0; i < cluster->shard_count; i++) {
+            if (socks[i] == INVALID_SOCKET || !FD_ISSET(socks[i], &readable)) continue;
+            
+            int n = recv(socks[i], (char*)buffers[i] + received[i],
+                         SHARD_RESPONSE_MAX - received[i], 0);
+            int status = -1;
+            if (n > 0) {
+                received[i] += n;
+                status = decode_shard_response(buffers[i], received[i], results);
+            }
+            
+            if (status == 1) answered++;
+            if (status != 0) {
+                closesocket(socks[i]);
+                socks[i] = INVALID_SOCKET;
+                pending--;
+            }
+        }
+    }
+    
+    for (int i = 0; i < cluster->shard_count; i++) {
+        if (socks[i] != INVALID_SOCKET) {
+            printf("Shard %d missed the %d ms deadline\n", i, cluster->deadline_ms);
+            closesocket(socks[i]);
+        }
+    }
+    
+    sort_enhanced_heap(results);
+    return answered;
+}
+
+// ==========================================
+// MODULE 9: CONTEXT MODEL (N-GRAMS)
+// ==========================================
+//
+// A bigram/trigram model built offline (build-lm) from a plain-text corpus
+// and memory-mapped by the server. Every kept n-gram of order 1-3 is a key
+// of a minimal perfect hash: bucket = h % bucket_count, and each bucket
+// stores a seed (or, for singleton buckets, the slot itself) that places
+// its keys without collisions, so a lookup is two array reads plus a
+// fingerprint check. Log-probabilities are quantized to one byte.
+//
+// File layout (host byte order): LmHeader | seeds[bucket_count] |
+// entries[key_count] | successors[successor_count] |
+// vocab_offsets[vocab_count + 1] | vocab strings
+//
+// Unigram and bigram entries also point at their top successors, which is
+// what /predict serves. Successors are limited to dictionary words, and the
+// vocab strings hold each word's output spelling (the corpus's most frequent
+// spelling if the dictionary has it, else the dictionary's); hashing always
+// uses the case-folded form.
+
+#define LM_MAGIC "NGLM"
+#define LM_VERSION 1
+#define LM_FILE "context.lm"
+#define LM_MAX_TOKEN 64
+#define LM_MIN_COUNT 2          // bigrams/trigrams seen fewer times are pruned
+#define LM_SUCCESSORS 5
+#define LM_KEYS_PER_BUCKET 4
+#define LM_LOGPROB_FLOOR -20.0
+#define LM_BACKOFF -0.916       // log(0.4), "stupid backoff" per missing order
+#define LM_DIRECT_SLOT 0x80000000u
+#define CONTEXT_WEIGHT 0.35
+// Rank cost of each edit beyond the first for model candidates; larger than
+// CONTEXT_WEIGHT, so context alone never buys back an extra edit
+#define CONTEXT_EDIT_RANK 0.4
+
+#define FNV64_OFFSET 14695981039346656037ULL
+#define FNV64_PRIME 1099511628211ULL
+
+typedef struct {
+    char magic[4];
+    unsigned int version;
+    unsigned int key_count;
+    unsigned int bucket_count;
+    unsigned int successor_count;
+    unsigned int vocab_count;
+    unsigned long long salt;
+    double logprob_step;        // quantized q means log-probability -q * step
+    unsigned long long seeds_offset;
+    unsigned long long entries_offset;
+    unsigned long long successors_offset;
+    unsigned long long vocab_offset;
+    unsigned long long strings_offset;
+    unsigned long long file_size;
+} LmHeader;
+
+typedef struct {
+    unsigned int fingerprint;
+    unsigned int successor_start;
+    unsigned char successor_count;
+    unsigned char logprob_q;    // log P(last token | preceding tokens)
+    unsigned char order;
+    unsigned char reserved;
+} LmEntry;
+
+typedef struct {
+    const unsigned char* base;
+    size_t size;
+    const LmHeader* header;
+    const unsigned int* seeds;
+    const LmEntry* entries;
+    const unsigned int* successors;   // vocab id << 8 | quantized log-probability
+    const unsigned int* vocab_offsets;
+    const char* strings;
+} LanguageModel;
+
+unsigned long long mix64(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+unsigned long long fnv64_codepoint(unsigned long long hash, unsigned int cp) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (cp >> (8 * i)) & 0xFF;
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+// Hash of a token sequence; tokens are case-folded here, and 0xFFFFFFFF
+// (never a codepoint) separates them
+unsigned long long ngram_hash(const char** tokens, int count) {
+    unsigned long long hash = FNV64_OFFSET;
+    unsigned int cp;
+    
+    for (int t = 0; t < count; t++) {
+        if (t > 0) hash = fnv64_codepoint(hash, 0xFFFFFFFFu);
+        for (const char* p = tokens[t]; *p; ) {
+            p += utf8_decode(p, &cp);
+            hash = fnv64_codepoint(hash, fold_codepoint(cp));
+        }
+    }
+    return hash;
+}
+
+int utf8_encode(unsigned int cp, char* out) {
+    if (cp < 0x80) { out[0] = (char)cp; return 1; }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Letters and digits; Latin-1 symbols and General Punctuation (quotes,
+// dashes, ellipsis) are treated as separators
+int is_token_codepoint(unsigned int cp) {
+    if (cp < 0x80) return isalnum((int)cp);
+    if (cp >= 0xA0 && cp <= 0xBF) return 0;
+    if (cp == 0xD7 || cp == 0xF7) return 0;
+    if (cp >= 0x2000 && cp <= 0x206F) return 0;
+    return 1;
+}
+
+// Reads the next word from *text into token (case-folded UTF-8) and, if raw
+// is not NULL, its original spelling. Apostrophes and hyphens count when
+// they sit between word characters. *boundary is set if a sentence ended
+// (.!? or a blank line) since the previous token.
+int next_token(const char** text, char* token, char* raw, int* boundary) {
+    const char* p = *text;
+    unsigned int cp;
+    int len = 0;
+    int raw_len = 0;
+    int newlines = 0;
+    
+    *boundary = 0;
+    while (*p) {
+        int n = utf8_decode(p, &cp);
+        if (is_token_codepoint(cp)) break;
+        if (cp == '.' || cp == '!' || cp == '?') *boundary = 1;
+        if (cp == '\n' && ++newlines >= 2) *boundary = 1;
+        if (cp != '\n' && cp != '\r' && cp != ' ' && cp != '\t') newlines = 0;
+        p += n;
+    }
+    
+    while (*p) {
+        int n = utf8_decode(p, &cp);
+        if (cp == 0x2019) cp = '\'';
+        
+        if (!is_token_codepoint(cp)) {
+            unsigned int next_cp = 0;
+            int joiner = (cp == '\'' || cp == '-') && len > 0 && p[n];
+            if (joiner) {
+                utf8_decode(p + n, &next_cp);
+                joiner = is_token_codepoint(next_cp);
+            }
+            if (!joiner) break;
+        }
+        
+        if (len < LM_MAX_TOKEN - 4 && raw_len < LM_MAX_TOKEN - 4) {
+            len += utf8_encode(fold_codepoint(cp), token + len);
+            if (raw) raw_len += utf8_encode(cp, raw + raw_len);
+        }
+        p += n;
+    }
+    
+    token[len] = '\0';
+    if (raw) raw[raw_len] = '\0';
+    *text = p;
+    return len;
+}
+
+// ------------------------------------------
+// Runtime: mmap'd lookups
+// ------------------------------------------
+
+void lm_close(LanguageModel* lm) {
+    if (!lm->base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(lm->base);
+#else
+    munmap((void*)lm->base, lm->size);
+#endif
+    lm->base = NULL;
+}
+
+// A section of count items of item_size bytes at offset lies inside the file
+int lm_section_fits(const LanguageModel* lm, unsigned long long offset,
+                    unsigned long long count, unsigned long long item_size) {
+    if (offset % sizeof(unsigned int) != 0 || offset > lm->size) return 0;
+    return count <= (lm->size - offset) / item_size;
+}
+
+// Every offset and index the lookups follow stays inside the mapping, so a
+// stale or truncated file is rejected instead of read out of bounds
+int lm_validate(const LanguageModel* lm) {
+    const LmHeader* h = lm->header;
+    
+    if (lm->size < sizeof(LmHeader) || memcmp(h->magic, LM_MAGIC, 4) != 0 ||
+        h->version != LM_VERSION || h->file_size != lm->size ||
+        h->key_count == 0 || h->bucket_count == 0 || h->logprob_step <= 0.0) {
+        return 0;
+    }
+    
+    if (!lm_section_fits(lm, h->seeds_offset, h->bucket_count, sizeof(unsigned int)) ||
+        !lm_section_fits(lm, h->entries_offset, h->key_count, sizeof(LmEntry)) ||
+        !lm_section_fits(lm, h->successors_offset, h->successor_count, sizeof(unsigned int)) ||
+        !lm_section_fits(lm, h->vocab_offset, (unsigned long long)h->vocab_count + 1, sizeof(unsigned int)) ||
+        h->strings_offset > lm->size) {
+        return 0;
+    }
+    
+    const unsigned int* seeds = (const unsigned int*)(lm->base + h->seeds_offset);
+    for (unsigned int b = 0; b < h->bucket_count; b++) {
+        if ((seeds[b] & LM_DIRECT_SLOT) && (seeds[b] & ~LM_DIRECT_SLOT) >= h->key_count) return 0;
+    }
+    
+    const LmEntry* entries = (const LmEntry*)(lm->base + h->entries_offset);
+    for (unsigned int i = 0; i < h->key_count; i++) {
+        if ((unsigned long long)entries[i].successor_start + entries[i].successor_count > h->successor_count) return 0;
+    }
+    
+    const unsigned int* successors = (const unsigned int*)(lm->base + h->successors_offset);
+    for (unsigned int i = 0; i < h->successor_count; i++) {
+        if ((successors[i] >> 8) >= h->vocab_count) return 0;
+    }
+    
+    // Strings are NUL-terminated back to back and end the file
+    const unsigned int* offsets = (const unsigned int*)(lm->base + h->vocab_offset);
+    const char* strings = (const char*)(lm->base + h->strings_offset);
+    if (offsets[h->vocab_count] != lm->size - h->strings_offset) return 0;
+    for (unsigned int v = 0; v < h->vocab_count; v++) {
+        if (offsets[v] >= offsets[v + 1] || strings[offsets[v + 1] - 1] != '\0') return 0;
+    }
+    return 1;
+}
+
+int lm_open(LanguageModel* lm, const char* filename) {
+    memset(lm, 0, sizeof(*lm));
+    
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return 0;
+    
+    const void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!base) return 0;
+    lm->size = (size_t)size.QuadPart;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LmHeader)) {
+        close(fd);
+        return 0;
+    }
+    
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return 0;
+    lm->size = st.st_size;
+#endif
+    
+    lm->base = (const unsigned char*)base;
+    lm->header = (const LmHeader*)base;
+    
+    if (!lm_validate(lm)) {
+        printf("Error: '%s' is not a usable context model\n", filename);
+        lm_close(lm);
+        return 0;
+    }
+    
+    const LmHeader* h = lm->header;
+    lm->seeds = (const unsigned int*)(lm->base + h->seeds_offset);
+    lm->entries = (const LmEntry*)(lm->base + h->entries_offset);
+    lm->successors = (const unsigned int*)(lm->base + h->successors_offset);
+    lm->vocab_offsets = (const unsigned int*)(lm->base + h->vocab_offset);
+    lm->strings = (const char*)(lm->base + h->strings_offset);
+    return 1;
+}
+
+unsigned int lm_slot(unsigned long long hash, unsigned int seed, unsigned int key_count) {
+    if (seed & LM_DIRECT_SLOT) return seed & ~LM_DIRECT_SLOT;
+    return (unsigned int)(mix64(hash ^ (seed * 0x9E3779B97F4A7C15ULL)) % key_count);
+}
+
+const LmEntry* lm_find(const LanguageModel* lm, unsigned long long hash) {
+    const LmHeader* h = lm->header;
+    unsigned int bucket = (unsigned int)(mix64(hash ^ h->salt) % h->bucket_count);
+    const LmEntry* entry = &lm->entries[lm_slot(hash, lm->seeds[bucket], h->key_count)];
+    return entry->fingerprint == (unsigned int)(hash >> 32) ? entry : NULL;
+}
+
+// log P(word | context) with stupid backoff down to n-grams of min_order;
+// LM_LOGPROB_FLOOR if even those are unseen
+double lm_logprob(const LanguageModel* lm, const char** context, int context_count, const char* word,
+                  int min_order) {
+    const char* tokens[3];
+    double penalty = 0.0;
+    
+    if (context_count > 2) {
+        context += context_count - 2;
+        context_count = 2;
+    }
+    
+    for (int n = context_count; n >= min_order - 1; n--) {
+        for (int i = 0; i < n; i++) tokens[i] = context[context_count - n + i];
+        tokens[n] = word;
+        
+        const LmEntry* entry = lm_find(lm, ngram_hash(tokens, n + 1));
+        if (entry && entry->order == n + 1) {
+            return penalty - entry->logprob_q * lm->header->logprob_step;
+        }
+        penalty += LM_BACKOFF;
+    }
+    return LM_LOGPROB_FLOOR;
+}
+
+// Splits the prev= text into its last (up to) two words
+int parse_context(const char* prev, char tokens[2][LM_MAX_TOKEN]) {
+    char token[LM_MAX_TOKEN];
+    int count = 0;
+    int boundary;
+    
+    while (next_token(&prev, token, NULL, &boundary) > 0) {
+        if (boundary) count = 0;
+        if (count == 2) {
+            strcpy(tokens[0], tokens[1]);
+            count = 1;
+        }
+        strcpy(tokens[count++], token);
+    }
+    return count;
+}
+
+// Optimal string alignment distance over case-folded codepoints. Works
+// without the dictionary alphabet, which the coordinator does not load.
+int folded_edit_distance(const char* a, const char* b) {
+    unsigned int s1[LM_MAX_TOKEN], s2[LM_MAX_TOKEN];
+    int d[LM_MAX_TOKEN + 1][LM_MAX_TOKEN + 1];
+    int len1 = 0, len2 = 0;
+    unsigned int cp;
+    
+    for (const char* p = a; *p && len1 < LM_MAX_TOKEN; len1++) {
+        p += utf8_decode(p, &cp);
+        s1[len1] = fold_codepoint(cp);
+    }
+    for (const char* p = b; *p && len2 < LM_MAX_TOKEN; len2++) {
+        p += utf8_decode(p, &cp);
+        s2[len2] = fold_codepoint(cp);
+    }
+    
+    for (int i = 0; i <= len1; i++) d[i][0] = i;
+    for (int j = 0; j <= len2; j++) d[0][j] = j;
+    
+    for (int i = 1; i <= len1; i++) {
+        for (int j = 1; j <= len2; j++) {
+            int best = d[i-1][j-1] + (s1[i-1] != s2[j-1]);
+            if (d[i-1][j] + 1 < best) best = d[i-1][j] + 1;
+            if (d[i][j-1] + 1 < best) best = d[i][j-1] + 1;
+            if (i > 1 && j > 1 && s1[i-1] == s2[j-2] && s1[i-2] == s2[j-1] && d[i-2][j-2] + 1 < best) {
+                best = d[i-2][j-2] + 1;
+            }
+            d[i][j] = best;
+        }
+    }
+    return d[len1][len2];
+}
+
+// The spelling pool can miss the intended word (thier -> their scores below
+// the cut-off), but the model knows what follows the context: add the
+// context's successors that are a small edit away from the input. A single
+// edit ranks with the best spelling candidate; the context boost decides.
+void add_context_candidates(const LanguageModel* lm, const LmEntry* entry, const char* input,
+                            double best_rank, EnhancedHeap* results) {
+    if (!entry) return;
+    
+    int max_edits = strlen(input) <= 4 ? 1 : 2;
+    for (int i = 0; i < entry->successor_count; i++) {
+        unsigned int vocab_id = lm->successors[entry->successor_start + i] >> 8;
+        const char* word = lm->strings + lm->vocab_offsets[vocab_id];
+        
+        int edits = folded_edit_distance(input, word);
+        if (edits <= max_edits) {
+            double rank = best_rank + CONTEXT_EDIT_RANK * (edits > 0 ? edits - 1 : 0);
+            add_enhanced_suggestion(results, (char*)word, rank, 2);
+        }
+    }
+}
+
+// Widens the pool with likely successors of prev, then boosts each
+// suggestion by how likely it is after prev and re-sorts. Only bigram and
+// trigram evidence counts: a unigram backoff would favour frequent words
+// like "the" after any context.
+void rerank_with_context(const LanguageModel* lm, const char* prev, const char* input,
+                         EnhancedHeap* results) {
+    char context_tokens[2][LM_MAX_TOKEN];
+    const char* context[2];
+    int context_count = parse_context(prev, context_tokens);
+    if (context_count == 0) return;
+    
+    for (int i = 0; i < context_count; i++) context[i] = context_tokens[i];
+    
+    double best_rank = 0.0;
+    for (int i = 0; i < results->count; i++) {
+        if (i == 0 || results->elements[i].rank < best_rank) best_rank = results->elements[i].rank;
+    }
+    
+    if (context_count == 2) {
+        const LmEntry* entry = lm_find(lm, ngram_hash(context, 2));
+        if (entry && entry->order == 2) add_context_candidates(lm, entry, input, best_rank, results);
+    }
+    const LmEntry* entry = lm_find(lm, ngram_hash(&context[context_count - 1], 1));
+    if (entry && entry->order == 1) add_context_candidates(lm, entry, input, best_rank, results);
+    
+    for (int i = 0; i < results->count; i++) {
+        double logprob = lm_logprob(lm, context, context_count, results->elements[i].word, 2);
+        results->elements[i].rank -= CONTEXT_WEIGHT * (1.0 - logprob / LM_LOGPROB_FLOOR);
+    }
+    sort_enhanced_heap(results);
+}
+
+void add_successors(const LanguageModel* lm, const LmEntry* entry, double penalty, EnhancedHeap* results) {
+    if (!entry) return;
+    
+    for (int i = 0; i < entry->successor_count; i++) {
+        unsigned int packed = lm->successors[entry->successor_start + i];
+        unsigned int vocab_id = packed >> 8;
+        double logprob = penalty - (packed & 0xFF) * lm->header->logprob_step;
+        
+        add_enhanced_suggestion(results, (char*)lm->strings + lm->vocab_offsets[vocab_id], -logprob, 1);
+    }
+}
+
+// Next-word prediction: trigram successors of the last two words, topped up
+// with (backed-off) bigram successors of the last word
+void predict_next_words(const LanguageModel* lm, const char* prev, EnhancedHeap* results) {
+    char context_tokens[2][LM_MAX_TOKEN];
+    const char* context[2];
+    
+    init_enhanced_heap(results, TOP_K);
+    int context_count = parse_context(prev, context_tokens);
+    if (context_count == 0) return;
+    
+    for (int i = 0; i < context_count; i++) context[i] = context_tokens[i];
+    
+    if (context_count == 2) {
+        const LmEntry* entry = lm_find(lm, ngram_hash(context, 2));
+        if (entry && entry->order == 2) add_successors(lm, entry, 0.0, results);
+    }
+    
+    const LmEntry* entry = lm_find(lm, ngram_hash(&context[context_count - 1], 1));
+    if (entry && entry->order == 1) {
+        add_successors(lm, entry, context_count == 2 ? LM_BACKOFF : 0.0, results);
+    }
+    
+    sort_enhanced_heap(results);
+}
+
+// ------------------------------------------
+// Offline build
+// ------------------------------------------
+
+typedef struct {
+    unsigned long long hash;
+    unsigned long long context_hash;
+    unsigned int count;
+    unsigned int last_word;
+    int order;
+    int kept_index;
+} NgramCount;
+
+typedef struct {
+    NgramCount* slots;
+    unsigned long long capacity;   // power of two
+    unsigned long long used;
+} NgramTable;
+
+NgramCount* ngram_table_find(NgramTable* table, unsigned long long hash) {
+    unsigned long long mask = table->capacity - 1;
+    for (unsigned long long i = mix64(hash) & mask; ; i = (i + 1) & mask) {
+        if (table->slots[i].count == 0 || table->slots[i].hash == hash) {
+            return &table->slots[i];
+        }
+    }
+}
+
+NgramCount* ngram_table_add(NgramTable* table, unsigned long long hash) {
+    if ((table->used + 1) * 2 > table->capacity) {
+        NgramTable grown;
+        grown.capacity = table->capacity ? table->capacity * 2 : 1 << 16;
+        grown.used = table->used;
+        grown.slots = (NgramCount*)calloc(grown.capacity, sizeof(NgramCount));
+        
+        for (unsigned long long i = 0; i < table->capacity; i++) {
+            if (table->slots[i].count > 0) {
+                *ngram_table_find(&grown, table->slots[i].hash) = table->slots[i];
+            }
+        }
+        free(table->slots);
+        *table = grown;
+    }
+    
+    NgramCount* slot = ngram_table_find(table, hash);
+    if (slot->count == 0) {
+        slot->hash = hash;
+        table->used++;
+    }
+    slot->count++;
+    return slot;
+}
+
+unsigned char quantize_logprob(double logprob, double step) {
+    double q = -logprob / step + 0.5;
+    if (q < 0) q = 0;
+    if (q > 255) q = 255;
+    return (unsigned char)q;
+}
+
+// Kept n-grams grouped by context, most frequent first
+int compare_successor_candidates(const void* a, const void* b) {
+    const NgramCount* x = *(const NgramCount* const*)a;
+    const NgramCount* y = *(const NgramCount* const*)b;
+    if (x->context_hash != y->context_hash) return x->context_hash < y->context_hash ? -1 : 1;
+    if (x->count != y->count) return x->count > y->count ? -1 : 1;
+    return (x->last_word > y->last_word) - (x->last_word < y->last_word);
+}
+
+typedef struct {
+    unsigned int bucket;
+    unsigned int size;
+    unsigned int first;
+} LmBucket;
+
+int compare_buckets_by_size(const void* a, const void* b) {
+    const LmBucket* x = (const LmBucket*)a;
+    const LmBucket* y = (const LmBucket*)b;
+    if (x->size != y->size) return x->size > y->size ? -1 : 1;
+    return (x->bucket > y->bucket) - (x->bucket < y->bucket);
+}
+
+// Assigns each of the n hashes a distinct slot in [0, n). Buckets are placed
+// largest first by trying seeds; singletons then take the remaining free
+// slots directly. Returns 0 if some bucket needs too many tries.
+int build_perfect_hash(const unsigned long long* hashes, unsigned int n, unsigned long long salt,
+                       unsigned int bucket_count, unsigned int* seeds, unsigned int* slot_of) {
+    LmBucket* buckets = (LmBucket*)calloc(bucket_count, sizeof(LmBucket));
+    unsigned int* order = (unsigned int*)malloc(n * sizeof(unsigned int));
+    unsigned int* bucket_of = (unsigned int*)malloc(n * sizeof(unsigned int));
+    unsigned char* taken = (unsigned char*)calloc(n, 1);
+    unsigned int slots[64];
+    int ok = 1;
+    
+    for (unsigned int b = 0; b < bucket_count; b++) buckets[b].bucket = b;
+    for (unsigned int i = 0; i < n; i++) {
+        bucket_of[i] = (unsigned int)(mix64(hashes[i] ^ salt) % bucket_count);
+        buckets[bucket_of[i]].size++;
+    }
+    
+    // Counting sort of keys by bucket so each bucket's keys are contiguous
+    unsigned int offset = 0;
+    for (unsigned int b = 0; b < bucket_count; b++) {
+        buckets[b].first = offset;
+        offset += buckets[b].size;
+    }
+    unsigned int* fill = (unsigned int*)calloc(bucket_count, sizeof(unsigned int));
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int b = bucket_of[i];
+        order[buckets[b].first + fill[b]++] = i;
+    }
+    free(fill);
+    
+    qsort(buckets, bucket_count, sizeof(LmBucket), compare_buckets_by_size);
+    
+    unsigned int next_free = 0;
+    for (unsigned int k = 0; k < bucket_count && ok; k++) {
+        LmBucket* bucket = &buckets[k];
+        const unsigned int* keys = order + bucket->first;
+        
+        if (bucket->size == 0) {
+            seeds[bucket->bucket] = 0;
+        } else if (bucket->size == 1) {
+            while (taken[next_free]) next_free++;
+            taken[next_free] = 1;
+            slot_of[keys[0]] = next_free;
+            seeds[bucket->bucket] = LM_DIRECT_SLOT | next_free;
+        } else if (bucket->size > 64) {
+            ok = 0;
+        } else {
+            unsigned int seed;
+            for (seed = 1; seed < 10000000; seed++) {
+                unsigned int placed = 0;
+                for (; placed < bucket->size; placed++) {
+                    unsigned int slot = lm_slot(hashes[keys[placed]], seed, n);
+                    int clash = taken[slot];
+                    for (unsigned int j = 0; j < placed && !clash; j++) clash = slots[j] == slot;
+                    if (clash) break;
+                    slots[placed] = slot;
+                }
+                if (placed == bucket->size) break;
+            }
+            
+            if (seed == 10000000) {
+                ok = 0;
+            } else {
+                for (unsigned int j = 0; j < bucket->size; j++) {
+                    taken[slots[j]] = 1;
+                    slot_of[keys[j]] = slots[j];
+                }
+                seeds[bucket->bucket] = seed;
+            }
+        }
+    }
+    
+    free(buckets);
+    free(order);
+    free(bucket_of);
+    free(taken);
+    return ok;
+}
+
+// FNV-1a over the exact bytes, for telling spellings apart
+unsigned long long spelling_hash(const char* word) {
+    unsigned long long hash = FNV64_OFFSET;
+    for (const unsigned char* p = (const unsigned char*)word; *p; p++) {
+        hash ^= *p;
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+int build_language_model(const char* corpus_filename, const char* out_filename,
+                         const char* dictionary_filename) {
+    long long start = now_ms();
+    long size;
+    char* text = read_whole_file(corpus_filename, &size);
+    if (!text) {
+        printf("Error: Could not open file '%s'\n", corpus_filename);
+        return 0;
+    }
+    
+    // Dictionary words by folded key (later lines win, as in the trie) and
+    // by exact spelling
+    char** dict_words;
+    int dict_count;
+    char* dict_data = read_word_list(dictionary_filename, &dict_words, &dict_count);
+    if (!dict_data || dict_count == 0) {
+        printf("Error: Could not open file '%s'\n", dictionary_filename);
+        free(text);
+        return 0;
+    }
+    
+    NgramTable dict_table = { NULL, 0, 0 };
+    NgramTable dict_spellings = { NULL, 0, 0 };
+    for (int i = 0; i < dict_count; i++) {
+        const char* word = dict_words[i];
+        ngram_table_add(&dict_table, ngram_hash(&word, 1))->kept_index = i;
+        ngram_table_add(&dict_spellings, spelling_hash(word));
+    }
+    
+    NgramTable table = { NULL, 0, 0 };
+    NgramTable vocab_table = { NULL, 0, 0 };
+    NgramTable spelling_table = { NULL, 0, 0 };
+    char** vocab = NULL;
+    char** spellings = NULL;
+    unsigned int vocab_count = 0, vocab_capacity = 0;
+    unsigned int spelling_count = 0, spelling_capacity = 0;
+    unsigned long long total_tokens = 0;
+    
+    // Count 1-3 grams; the context resets at sentence boundaries
+    char window[3][LM_MAX_TOKEN];
+    int window_len = 0;
+    char token[LM_MAX_TOKEN];
+    char raw[LM_MAX_TOKEN];
+    int boundary;
+    const char* p = text;
+    
+    while (next_token(&p, token, raw, &boundary) > 0) {
+        if (boundary) window_len = 0;
+        if (window_len == 3) {
+            memmove(window[0], window[1], sizeof(window[0]) * 2);
+            window_len = 2;
+        }
+        strcpy(window[window_len++], token);
+        total_tokens++;
+        
+        const char* last = window[window_len - 1];
+        unsigned long long word_hash = ngram_hash(&last, 1);
+        NgramCount* word_entry = ngram_table_add(&vocab_table, word_hash);
+        if (word_entry->count == 1) {
+            if (vocab_count == vocab_capacity) {
+                vocab_capacity = vocab_capacity ? vocab_capacity * 2 : 4096;
+                vocab = (char**)realloc(vocab, vocab_capacity * sizeof(char*));
+            }
+            word_entry->last_word = vocab_count;
+            vocab[vocab_count++] = strdup(token);
+        }
+        unsigned int word_id = word_entry->last_word;
+        
+        NgramCount* spelling = ngram_table_add(&spelling_table, spelling_hash(raw));
+        if (spelling->count == 1) {
+            if (spelling_count == spelling_capacity) {
+                spelling_capacity = spelling_capacity ? spelling_capacity * 2 : 4096;
+                spellings = (char**)realloc(spellings, spelling_capacity * sizeof(char*));
+            }
+            spelling->last_word = word_id;
+            spelling->kept_index = spelling_count;
+            spellings[spelling_count++] = strdup(raw);
+        }
+        
+        for (int n = 1; n <= window_len; n++) {
+            const char* tokens[3];
+            for (int i = 0; i < n; i++) tokens[i] = window[window_len - n + i];
+            
+            NgramCount* entry = ngram_table_add(&table, ngram_hash(tokens, n));
+            entry->order = n;
+            entry->last_word = word_id;
+            entry->context_hash = n > 1 ? ngram_hash(tokens, n - 1) : 0;
+        }
+    }
+    free(text);
+    
+    if (total_tokens == 0) {
+        printf("Error: No words found in '%s'\n", corpus_filename);
+        return 0;
+    }
+    
+    // Output spelling per word: the most frequent one in the corpus if the
+    // dictionary has it verbatim, otherwise the dictionary's own spelling.
+    // Words missing from the dictionary are never offered as successors.
+    const char** output = (const char**)calloc(vocab_count, sizeof(char*));
+    unsigned int* output_count = (unsigned int*)calloc(vocab_count, sizeof(unsigned int));
+    unsigned char* in_dictionary = (unsigned char*)calloc(vocab_count, 1);
+    for (unsigned long long i = 0; i < spelling_table.capacity; i++) {
+        NgramCount* entry = &spelling_table.slots[i];
+        if (entry->count > output_count[entry->last_word]) {
+            output_count[entry->last_word] = entry->count;
+            output[entry->last_word] = spellings[entry->kept_index];
+        }
+    }
+    
+    unsigned int dictionary_words = 0;
+    for (unsigned int v = 0; v < vocab_count; v++) {
+        const char* word = vocab[v];
+        NgramCount* entry = ngram_table_find(&dict_table, ngram_hash(&word, 1));
+        if (entry->count == 0) continue;
+        
+        in_dictionary[v] = 1;
+        dictionary_words++;
+        if (ngram_table_find(&dict_spellings, spelling_hash(output[v]))->count == 0) {
+            output[v] = dict_words[entry->kept_index];
+        }
+    }
+    
+    // Keep every unigram and the bigrams/trigrams seen often enough
+    NgramCount** kept = (NgramCount**)malloc(table.used * sizeof(NgramCount*));
+    unsigned int key_count = 0;
+    for (unsigned long long i = 0; i < table.capacity; i++) {
+        NgramCount* entry = &table.slots[i];
+        if (entry->count == 0) continue;
+        if (entry->order == 1 || entry->count >= LM_MIN_COUNT) {
+            entry->kept_index = key_count;
+            kept[key_count++] = entry;
+        } else {
+            entry->kept_index = -1;
+        }
+    }
+    
+    double step = -LM_LOGPROB_FLOOR / 255.0;
+    LmEntry* entries = (LmEntry*)calloc(key_count, sizeof(LmEntry));
+    unsigned long long* hashes = (unsigned long long*)malloc(key_count * sizeof(unsigned long long));
+    
+    for (unsigned int k = 0; k < key_count; k++) {
+        NgramCount* entry = kept[k];
+        double context_count = (double)total_tokens;
+        if (entry->order > 1) {
+            context_count = ngram_table_find(&table, entry->context_hash)->count;
+        }
+        
+        hashes[k] = entry->hash;
+        entries[k].fingerprint = (unsigned int)(entry->hash >> 32);
+        entries[k].order = (unsigned char)entry->order;
+        entries[k].logprob_q = quantize_logprob(log(entry->count / context_count), step);
+    }
+    
+    // Top successors per context: sort bigrams/trigrams by (context, count)
+    NgramCount** followers = (NgramCount**)malloc(key_count * sizeof(NgramCount*));
+    unsigned int follower_count = 0;
+    for (unsigned int k = 0; k < key_count; k++) {
+        if (kept[k]->order > 1) followers[follower_count++] = kept[k];
+    }
+    qsort(followers, follower_count, sizeof(NgramCount*), compare_successor_candidates);
+    
+    unsigned int* successors = (unsigned int*)malloc((follower_count + 1) * sizeof(unsigned int));
+    unsigned int successor_count = 0;
+    for (unsigned int i = 0; i < follower_count; ) {
+        unsigned int group_end = i;
+        while (group_end < follower_count && followers[group_end]->context_hash == followers[i]->context_hash) {
+            group_end++;
+        }
+        
+        NgramCount* context = ngram_table_find(&table, followers[i]->context_hash);
+        if (context->count > 0 && context->kept_index >= 0) {
+            LmEntry* context_entry = &entries[context->kept_index];
+            context_entry->successor_start = successor_count;
+            for (unsigned int j = i; j < group_end && context_entry->successor_count < LM_SUCCESSORS; j++) {
+                if (!in_dictionary[followers[j]->last_word]) continue;
+                successors[successor_count++] = (followers[j]->last_word << 8) |
+                    entries[followers[j]->kept_index].logprob_q;
+                context_entry->successor_count++;
+            }
+        }
+        i = group_end;
+    }
+    
+    // Minimal perfect hash over all kept keys
+    unsigned int bucket_count = key_count / LM_KEYS_PER_BUCKET + 1;
+    unsigned int* seeds = (unsigned int*)calloc(bucket_count, sizeof(unsigned int));
+    unsigned int* slot_of = (unsigned int*)malloc(key_count * sizeof(unsigned int));
+    unsigned long long salt = 0x5DEECE66DULL;
+    
+    while (!build_perfect_hash(hashes, key_count, salt, bucket_count, seeds, slot_of)) {
+        salt = mix64(salt + 1);
+    }
+    
+    LmEntry* placed = (LmEntry*)calloc(key_count, sizeof(LmEntry));
+    for (unsigned int k = 0; k < key_count; k++) placed[slot_of[k]] = entries[k];
+    
+    // Vocabulary string table
+    unsigned int* vocab_offsets = (unsigned int*)malloc((vocab_count + 1) * sizeof(unsigned int));
+    unsigned int strings_size = 0;
+    for (unsigned int v = 0; v < vocab_count; v++) {
+        vocab_offsets[v] = strings_size;
+        strings_size += strlen(output[v]) + 1;
+    }
+    vocab_offsets[vocab_count] = strings_size;
+    
+    LmHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LM_MAGIC, 4);
+    header.version = LM_VERSION;
+    header.key_count = key_count;
+    header.bucket_count = bucket_count;
+    header.successor_count = successor_count;
+    header.vocab_count = vocab_count;
+    header.salt = salt;
+    header.logprob_step = step;
+    header.seeds_offset = sizeof(LmHeader);
+    header.entries_offset = header.seeds_offset + (unsigned long long)bucket_count * sizeof(unsigned int);
+    header.successors_offset = header.entries_offset + (unsigned long long)key_count * sizeof(LmEntry);
+    header.vocab_offset = header.successors_offset + (unsigned long long)successor_count * sizeof(unsigned int);
+    header.strings_offset = header.vocab_offset + (unsigned long long)(vocab_count + 1) * sizeof(unsigned int);
+    header.file_size = header.strings_offset + strings_size;
+    
+    FILE* out = fopen(out_filename, "wb");
+    if (!out) {
+        printf("Error: Could not write file '%s'\n", out_filename);
+        return 0;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(seeds, sizeof(unsigned int), bucket_count, out);
+    fwrite(placed, sizeof(LmEntry), key_count, out);
+    fwrite(successors, sizeof(unsigned int), successor_count, out);
+    fwrite(vocab_offsets, sizeof(unsigned int), vocab_count + 1, out);
+    for (unsigned int v = 0; v < vocab_count; v++) {
+        fwrite(output[v], 1, strlen(output[v]) + 1, out);
+    }
+    fclose(out);
+    
+    printf("Context model: %llu tokens, %u words (%u in the dictionary), %u n-grams kept, %.1f MB -> %s (%lld ms)\n",
+           total_tokens, vocab_count, dictionary_words, key_count, header.file_size / (1024.0 * 1024.0),
+           out_filename, now_ms() - start);
+    
+    for (unsigned int v = 0; v < vocab_count; v++) free(vocab[v]);
+    free(vocab);
+    for (unsigned int i = 0; i < spelling_count; i++) free(spellings[i]);
+    free(spellings);
+    free(output);
+    free(output_count);
+    free(in_dictionary);
+    free(spelling_table.slots);
+    free(dict_table.slots);
+    free(dict_spellings.slots);
+    free(dict_words);
+    free(dict_data);
+    free(vocab_offsets);
+    free(placed);
+    free(slot_of);
+    free(seeds);
+    free(successors);
+    free(followers);
+    free(hashes);
+    free(entries);
+    free(kept);
+    free(table.slots);
+    free(vocab_table.slots);
+    return 1;
+}
+
+// ==========================================
+// MODULE 10: HTTP SERVER
+// ==========================================
+
+// partial marks a sharded answer that is missing some shards' results
+char* create_json_response(EnhancedHeap* heap, const char* field, int partial) {
+    static char response[2048];
+    sprintf(response, "{\"%s\":[", field);
+    
+    for (int i = 0; i < heap->count; i++) {
+        strcat(response, "\"");
+        strcat(response, heap->elements[i].word);
+        strcat(response, "\"");
+        if (i < heap->count - 1) {
+            strcat(response, ",");
+        }
+    }
+    strcat(response, partial ? "],\"partial\":true}" : "]}");
+    
+    return response;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Returns the percent-decoded value, so "don%27t" and UTF-8 "%C3%A9" arrive
+// intact. A value longer than 255 bytes keeps its end (for prev= the words
+// nearest the caret matter), starting at a whole UTF-8 sequence. The result
+// lives in a static buffer until the next call.
+char* extract_query_param(const char* request, const char* param) {
+    static char value[256];
+    char decoded[2048];
+    int param_len = strlen(param);
+    const char* pos = strstr(request, param);
+    
+    // Only match a whole parameter name ("?word=" / "&word="), not a value
+    while (pos && !(pos > request && (pos[-1] == '?' || pos[-1] == '&') && pos[param_len] == '=')) {
+        pos = strstr(pos + 1, param);
+    }
+    if (!pos) return NULL;
+    
+    pos += param_len + 1;
+    int len = 0;
+    while (*pos && *pos != ' ' && *pos != '&' && *pos != '\r' && len < (int)sizeof(decoded) - 1) {
+        if (*pos == '%' && hex_value(pos[1]) >= 0 && hex_value(pos[2]) >= 0) {
+            decoded[len++] = (char)(hex_value(pos[1]) * 16 + hex_value(pos[2]));
+            pos += 3;
+        } else {
+            decoded[len++] = (*pos == '+') ? ' ' : *pos;
+            pos++;
+        }
+    }
     
-    start_server(root);
+    int from = len > (int)sizeof(value) - 1 ? len - ((int)sizeof(value) - 1) : 0;
+    while (from > 0 && from < len && ((unsigned char)decoded[from] & 0xC0) == 0x80) from++;
+    memcpy(value, decoded + from, len - from);
+    value[len - from] = '\0';
+    
+    return value;
+}
+
+const char* http_response_template = 
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "%s";
+
+void send_json(SOCKET client_socket, EnhancedHeap* heap, const char* field, int partial) {
+    char* json_response = create_json_response(heap, field, partial);
+    
+    char full_response[4096];
+    sprintf(full_response, http_response_template, json_response);
+    send(client_socket, full_response, strlen(full_response), 0);
+    
+    for (int i = 0; i < heap->count; i++) {
+        free(heap->elements[i].word);
+    }
+}
+
+void handle_request(SOCKET client_socket, TrieNode* root, ShardCluster* cluster, const LanguageModel* lm) {
+    char buffer[2048];
+    int n = recv(client_socket, buffer, sizeof(buffer)-1, 0);
+    buffer[n > 0 ? n : 0] = '\0';
+    
+    if (strstr(buffer, "GET /suggest?") != NULL) {
+        char word[256];
+        char prev[256];
+        char* value = extract_query_param(buffer, "prev");
+        strcpy(prev, value ? value : "");
+        
+        value = extract_query_param(buffer, "word");
+        if (value && strlen(value) > 0) {
+            strcpy(word, value);
+            
+            // With context, pull a wider candidate pool so reranking can
+            // promote a word that edit distance alone ranked below Top-K
+            int use_context = lm && strlen(prev) > 0;
+            int capacity = use_context ? RERANK_POOL : TOP_K;
+            
+            EnhancedHeap suggestions;
+            int partial = 0;
+            if (cluster) {
+                int answered = gather_shard_suggestions(cluster, word, &suggestions, capacity);
+                if (answered == 0) {
+                    const char* unavailable = "HTTP/1.1 503 Service Unavailable\r\n"
+                                              "Access-Control-Allow-Origin: *\r\n\r\n"
+                                              "{\"error\":\"No shard answered\"}";
+                    send(client_socket, unavailable, strlen(unavailable), 0);
+                    return;
+                }
+                partial = answered < cluster->shard_count;
+            } else {
+                get_enhanced_suggestions(root, word, &suggestions, capacity);
+            }
+            
+            if (use_context) {
+                rerank_with_context(lm, prev, word, &suggestions);
+                truncate_enhanced_heap(&suggestions, TOP_K);
+            }
+            
+            send_json(client_socket, &suggestions, "suggestions", partial);
+        } else {
+            const char* bad_req = "HTTP/1.1 400 Bad Request\r\n\r\n{\"error\":\"Missing word\"}";
+            send(client_socket, bad_req, strlen(bad_req), 0);
+        }
+    } else if (strstr(buffer, "GET /predict?") != NULL) {
+        char* prev = extract_query_param(buffer, "prev");
+        if (prev && strlen(prev) > 0) {
+            EnhancedHeap predictions;
+            if (lm) {
+                predict_next_words(lm, prev, &predictions);
+            } else {
+                init_enhanced_heap(&predictions, TOP_K);
+            }
+            
+            send_json(client_socket, &predictions, "predictions", 0);
+        } else {
+            const char* bad_req = "HTTP/1.1 400 Bad Request\r\n\r\n{\"error\":\"Missing prev\"}";
+            send(client_socket, bad_req, strlen(bad_req), 0);
+        }
+    } else {
+        const char* not_found = "HTTP/1.1 404 Not Found\r\n\r\n{\"error\":\"Not found\"}";
+        send(client_socket, not_found, strlen(not_found), 0);
+    }
+}
+
+// cluster == NULL serves suggestions from the local trie; otherwise every
+// query is scattered over the shard processes. lm (optional) reranks by
+// context and serves /predict.
+void start_server(TrieNode* root, ShardCluster* cluster, const LanguageModel* lm) {
+    struct sockaddr_in address;
+    socklen_t addrlen = sizeof(address);
+    
+    SOCKET server_fd = open_listener(INADDR_ANY, SERVER_PORT);
+    if (server_fd == INVALID_SOCKET) return;
+    
+    printf("Server listening on http://localhost:%d/suggest?word=yourword\n", SERVER_PORT);
+    if (cluster) {
+        printf("Coordinating %d shards on 127.0.0.1:%d-%d (deadline %d ms)\n",
+               cluster->shard_count, cluster->base_port,
+               cluster->base_port + cluster->shard_count - 1, cluster->deadline_ms);
+    }
+    
+    while (1) {
+        SOCKET new_socket = accept(server_fd, (struct sockaddr *)&address, &addrlen);
+        if (new_socket != INVALID_SOCKET) {
+            handle_request(new_socket, root, cluster, lm);
+            closesocket(new_socket);
+        }
+    }
+    
+    closesocket(server_fd);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+// ==========================================
+// MODULE 11: MAIN
+// ==========================================
+
+void print_usage(const char* program) {
+    printf("Usage:\n");
+    printf("  %s                                           standalone server\n", program);
+    printf("  %s shard <id> <count> [base_port]            serve one dictionary shard\n", program);
+    printf("  %s coordinator <count> [base_port] [deadline_ms]   fan /suggest out to shards\n", program);
+    printf("  %s bench-build [dictionary] [legacy]         time the dictionary build and exit\n", program);
+    printf("  %s gen-words <count> <out_file>              write a synthetic sorted word list\n", program);
+    printf("  %s build-lm <corpus.txt> [out_file] [dictionary]   build the context model (default %s)\n", program, LM_FILE);
+}
+
+// The context model is optional; without it prev= is ignored and /predict is empty
+LanguageModel* open_context_model(LanguageModel* model) {
+    if (!lm_open(model, LM_FILE)) {
+        printf("No context model (%s); prev= will be ignored\n", LM_FILE);
+        return NULL;
+    }
+    printf("Context model: %u n-grams, %u words (%s, memory-mapped)\n",
+           model->header->key_count, model->header->vocab_count, LM_FILE);
+    return model;
+}
+
+int main(int argc, char** argv) {
+    printf("========================================\n");
+    printf("   ENHANCED SPELL CHECKER v2.0\n");
+    printf("========================================\n\n");
+    
+    if (argc >= 4 && strcmp(argv[1], "shard") == 0) {
+        int shard_id = atoi(argv[2]);
+        int shard_count = atoi(argv[3]);
+        int base_port = argc > 4 ? atoi(argv[4]) : SHARD_BASE_PORT;
+        
+        if (shard_count < 1 || shard_count > MAX_SHARDS || shard_id < 0 || shard_id >= shard_count) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        
+        TrieNode* root = create_node();
+        printf("Loading dictionary shard...\n");
+        bulk_load_dictionary(root, "allword.txt", shard_id, shard_count);
+        printf("\n");
+        
+        start_shard_server(root, base_port + shard_id);
+        return 0;
+    }
+    
+    if (argc >= 3 && strcmp(argv[1], "coordinator") == 0) {
+        ShardCluster cluster;
+        cluster.shard_count = atoi(argv[2]);
+        cluster.base_port = argc > 3 ? atoi(argv[3]) : SHARD_BASE_PORT;
+        cluster.deadline_ms = argc > 4 ? atoi(argv[4]) : SHARD_DEADLINE_MS;
+        
+        if (cluster.shard_count < 1 || cluster.shard_count > MAX_SHARDS || cluster.deadline_ms < 1) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        
+        LanguageModel model;
+        start_server(NULL, &cluster, open_context_model(&model));
+        return 0;
+    }
+    
+    if (argc >= 2 && strcmp(argv[1], "bench-build") == 0) {
+        const char* dictionary = argc > 2 ? argv[2] : "allword.txt";
+        TrieNode* root = create_node();
+        
+        if (argc > 3 && strcmp(argv[3], "legacy") == 0) {
+            long long start = now_ms();
+            load_dictionary_from_file(root, dictionary);
+            printf("Built in %lld ms (insert_word path): peak memory %.1f MB\n",
+                   now_ms() - start, peak_memory_kb() / 1024.0);
+        } else {
+            bulk_load_dictionary(root, dictionary, 0, 1);
+        }
+        return 0;
+    }
+    
+    if (argc >= 4 && strcmp(argv[1], "gen-words") == 0) {
+        return generate_word_list("allword.txt", atoi(argv[2]), argv[3]) ? 0 : 1;
+    }
+    
+    if (argc >= 3 && strcmp(argv[1], "build-lm") == 0) {
+        return build_language_model(argv[2], argc > 3 ? argv[3] : LM_FILE,
+                                    argc > 4 ? argv[4] : "allword.txt") ? 0 : 1;
+    }
+    
+    if (argc > 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    TrieNode* root = create_node();
+    
+    printf("Loading dictionary...\n");
+    bulk_load_dictionary(root, "allword.txt", 0, 1);
+    
+    LanguageModel model;
+    LanguageModel* lm = open_context_model(&model);
+    printf("\n");
+    
+    start_server(root, NULL, lm);
     
     return 0;
-}
\ No newline at end of file
+}